@@ -0,0 +1,105 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Keeps results alive so the optimiser cannot drop the work being timed.
+inline volatile uint64_t benchSink;
+
+// Nanoseconds per call over several independent samples.
+struct Measurement {
+    double meanNs = 0;
+    double stddevNs = 0;
+    int samples = 0;
+};
+
+struct BenchResult {
+    std::string name;
+    Measurement time;
+};
+
+// Calls `op` in growing batches until at least `minSeconds` have passed and
+// returns the average nanoseconds per call.
+template <class Op>
+double MeasureNs(Op&& op, double minSeconds = 0.2) {
+    using Clock = std::chrono::steady_clock;
+    uint64_t calls = 0;
+    uint64_t batch = 1;
+    const auto begin = Clock::now();
+    double elapsed = 0;
+    while (elapsed < minSeconds) {
+        for (uint64_t i = 0; i < batch; ++i) op();
+        calls += batch;
+        batch *= 2;
+        elapsed = std::chrono::duration<double>(Clock::now() - begin).count();
+    }
+    return elapsed * 1e9 / double(calls);
+}
+
+// Mean and sample standard deviation.
+inline Measurement Summarize(const std::vector<double>& times) {
+    Measurement m;
+    m.samples = int(times.size());
+    for (double t : times) m.meanNs += t;
+    m.meanNs /= std::max(1, m.samples);
+    for (double t : times) m.stddevNs += (t - m.meanNs) * (t - m.meanNs);
+    m.stddevNs = m.samples > 1 ? std::sqrt(m.stddevNs / (m.samples - 1)) : 0;
+    return m;
+}
+
+// Sizes a batch to take about `sampleSeconds`, then times `samples` such
+// batches so the spread between them can be reported next to the mean.
+template <class Op>
+Measurement Measure(Op&& op, int samples = 15, double sampleSeconds = 0.02) {
+    using Clock = std::chrono::steady_clock;
+    const double estimate = MeasureNs(op, sampleSeconds);
+    const auto batch = uint64_t(std::max(1.0, sampleSeconds * 1e9 / estimate));
+
+    std::vector<double> times;
+    for (int s = 0; s < samples; ++s) {
+        const auto begin = Clock::now();
+        for (uint64_t i = 0; i < batch; ++i) op();
+        times.push_back(
+            std::chrono::duration<double>(Clock::now() - begin).count() *
+            1e9 / double(batch));
+    }
+    return Summarize(times);
+}
+
+// The benchmarks picked by `--filter` (a substring of the name) and what
+// they measured, in the order they ran.
+struct Suite {
+    std::string filter;
+    std::vector<BenchResult> results;
+
+    bool wants(const std::string& name) const {
+        return name.find(filter) != std::string::npos;
+    }
+
+    void add(const std::string& name, Measurement time) {
+        results.push_back({name, time});
+    }
+
+    // `perCall` is how many operations one call of `op` does.
+    template <class Op>
+    void run(const std::string& name, Op&& op, int perCall = 1) {
+        if (!wants(name)) return;
+        Measurement time = Measure(op);
+        time.meanNs /= perCall;
+        time.stddevNs /= perCall;
+        add(name, time);
+    }
+};
+
+// Report.cpp
+void PrintResults(const std::vector<BenchResult>& results);
+bool WriteJson(const char* path, const std::vector<BenchResult>& results);
+bool ReadJson(const char* path, std::vector<BenchResult>& results);
+// Prints how each result moved against the baseline and returns how many
+// got slower by more than `thresholdPercent`.
+int CompareWithBaseline(const std::vector<BenchResult>& results,
+                        const std::vector<BenchResult>& baseline,
+                        double thresholdPercent);
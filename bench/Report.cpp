@@ -0,0 +1,93 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include "Bench.hpp"
+
+void PrintResults(const std::vector<BenchResult>& results) {
+    std::printf("%-28s %12s %10s\n", "benchmark", "ns/op", "stddev");
+    for (const BenchResult& result : results) {
+        std::printf("%-28s %12.1f %9.1f%%\n", result.name.c_str(),
+                    result.time.meanNs,
+                    result.time.meanNs > 0
+                        ? 100 * result.time.stddevNs / result.time.meanNs
+                        : 0.0);
+    }
+}
+
+bool WriteJson(const char* path, const std::vector<BenchResult>& results) {
+    std::FILE* out = std::fopen(path, "w");
+    if (!out) return false;
+    std::fprintf(out, "{\n  \"benchmarks\": [\n");
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& result = results[i];
+        std::fprintf(out,
+                     "    {\"name\": \"%s\", \"ns_per_op\": %.3f, "
+                     "\"stddev_ns\": %.3f, \"samples\": %d}%s\n",
+                     result.name.c_str(), result.time.meanNs,
+                     result.time.stddevNs, result.time.samples,
+                     i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(out, "  ]\n}\n");
+    return std::fclose(out) == 0;
+}
+
+// Only reads back what WriteJson writes: every "name" is followed by its
+// "ns_per_op" and "stddev_ns".
+bool ReadJson(const char* path, std::vector<BenchResult>& results) {
+    std::FILE* in = std::fopen(path, "r");
+    if (!in) return false;
+    std::string text;
+    char buffer[4096];
+    for (std::size_t n; (n = std::fread(buffer, 1, sizeof buffer, in)) > 0;) {
+        text.append(buffer, n);
+    }
+    std::fclose(in);
+
+    auto number = [&](std::size_t from, const char* key) {
+        std::size_t at = text.find(key, from);
+        if (at == std::string::npos) return 0.0;
+        return std::strtod(text.c_str() + at + std::strlen(key), nullptr);
+    };
+    results.clear();
+    for (std::size_t at = 0;
+         (at = text.find("\"name\": \"", at)) != std::string::npos;) {
+        at += std::strlen("\"name\": \"");
+        const std::size_t end = text.find('"', at);
+        if (end == std::string::npos) return false;
+        BenchResult result;
+        result.name = text.substr(at, end - at);
+        result.time.meanNs = number(end, "\"ns_per_op\":");
+        result.time.stddevNs = number(end, "\"stddev_ns\":");
+        results.push_back(result);
+        at = end;
+    }
+    return true;
+}
+
+int CompareWithBaseline(const std::vector<BenchResult>& results,
+                        const std::vector<BenchResult>& baseline,
+                        double thresholdPercent) {
+    int regressions = 0;
+    std::printf("\n%-28s %12s %12s %8s\n", "against baseline", "then",
+                "now", "change");
+    for (const BenchResult& result : results) {
+        const BenchResult* before = nullptr;
+        for (const BenchResult& old : baseline) {
+            if (old.name == result.name) before = &old;
+        }
+        if (!before or before->time.meanNs <= 0) {
+            std::printf("%-28s %12s %12.1f\n", result.name.c_str(), "-",
+                        result.time.meanNs);
+            continue;
+        }
+        const double change =
+            100 * (result.time.meanNs / before->time.meanNs - 1);
+        const bool slower = change > thresholdPercent;
+        regressions += slower;
+        std::printf("%-28s %12.1f %12.1f %+7.1f%%%s\n", result.name.c_str(),
+                    before->time.meanNs, result.time.meanNs, change,
+                    slower ? "  REGRESSION" : "");
+    }
+    return regressions;
+}
@@ -0,0 +1,331 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "Args.hpp"
+#include "Batch.hpp"
+#include "Bench.hpp"
+#include "DealDb.hpp"
+#include "Game.hpp"
+#include "Klondike.hpp"
+#include "Layout.hpp"
+#include "MoveMatrix.hpp"
+#include "Random.hpp"
+#include "Snapshot.hpp"
+#include "Solver.hpp"
+#include "Tweens.hpp"
+
+using namespace klondike;
+
+namespace {
+
+// Column 0 holds `count` face-up cards; everything else is in the stock.
+State FannedColumn(int count) {
+    State state = {};
+    Deck deck = orderedDeck();
+    for (int i = 0; i < DECK_SIZE; ++i) {
+        state.cards[i] = i < count ? deck[i].faceUp() : deck[i];
+    }
+    for (auto& end : state.columnEnd) end = uint8_t(count);
+    state.talonSize = uint8_t(DECK_SIZE - count);
+    return state;
+}
+
+// Positions from the middle of games: a few dozen random legal moves into
+// many different deals, so the hot paths see varied piles.
+std::vector<State> MidgameStates(int count) {
+    std::vector<State> states;
+    Random random(12345);
+    for (int i = 0; i < count; ++i) {
+        State state = dealFromSeed(uint64_t(i));
+        const uint64_t length = 10 + random.below(60);
+        for (uint64_t j = 0; j < length; ++j) {
+            MoveList moves;
+            state.legalMoves(moves);
+            if (moves.empty()) break;
+            state.apply(moves[int(random.below(uint64_t(moves.size())))]);
+        }
+        states.push_back(state);
+    }
+    return states;
+}
+
+// What CheckMouseInput used to do: test every face-up card's rectangle,
+// top card first, in every column.
+Hit ScanPick(const State& state, const Layout& layout,
+             const Point positions[], Point point) {
+    const Point size = layout.cardSize();
+    for (int i = 0; i < TABLEAU_COUNT; ++i) {
+        auto column = state.column(i);
+        for (int j = int(column.size()) - 1; j >= 0; --j) {
+            const Point p = positions[column[j].id()];
+            if (column[j].isFaceUp() and point.x >= p.x and
+                point.x < p.x + size.x and point.y >= p.y and
+                point.y < p.y + size.y) {
+                return {TABLEAU + i, j};
+            }
+        }
+    }
+    return {-1, 0};
+}
+
+void BenchRules(Suite& suite) {
+    uint64_t seed = 0;
+    suite.run("deal", [&] {
+        State state = dealFromSeed(seed++);
+        benchSink = benchSink + state.cards[0].bits;
+    });
+
+    std::vector<State> states = MidgameStates(1024);
+    std::size_t next = 0;
+    suite.run("legal_moves", [&] {
+        MoveList moves;
+        states[next++ % states.size()].legalMoves(moves);
+        benchSink = benchSink + uint64_t(moves.size());
+    });
+
+    // One call checks a target against the whole deck.
+    const Deck deck = orderedDeck();
+    suite.run(
+        "card_checks",
+        [&] {
+            const Card target = deck[next++ % deck.size()];
+            uint64_t stackable = 0;
+            for (Card card : deck) {
+                stackable +=
+                    suitReliable(card, target) + canStack(card, target);
+            }
+            benchSink = benchSink + stackable;
+        },
+        2 * DECK_SIZE);
+
+    // The first legal move of each position, applied and taken back.
+    std::vector<Move> firstMoves;
+    for (const State& state : states) {
+        MoveList moves;
+        state.legalMoves(moves);
+        firstMoves.push_back(moves.empty() ? Move{} : moves[0]);
+    }
+    suite.run(
+        "apply_undo",
+        [&] {
+            const std::size_t i = next++ % states.size();
+            if (firstMoves[i].count == 0) return;
+            MoveRecord record = states[i].apply(firstMoves[i]);
+            states[i].undo(record);
+            benchSink = benchSink + record.flipped;
+        });
+
+    // The same, keeping each position's legal moves current: compare with
+    // apply_undo plus two legal_moves.
+    std::vector<MoveMatrix> matrices(states.size());
+    for (std::size_t i = 0; i < states.size(); ++i) {
+        matrices[i].reset(states[i]);
+    }
+    suite.run(
+        "matrix_apply_undo",
+        [&] {
+            const std::size_t i = next++ % states.size();
+            if (firstMoves[i].count == 0) return;
+            MoveRecord record = states[i].apply(firstMoves[i]);
+            matrices[i].update(states[i], firstMoves[i]);
+            states[i].undo(record);
+            matrices[i].update(states[i], firstMoves[i]);
+            benchSink = benchSink + uint64_t(matrices[i].targets(WASTE));
+        });
+}
+
+// Timed per node: each deal searched for a fixed budget is one sample.
+void BenchSolver(Suite& suite) {
+    if (!suite.wants("solver_node")) return;
+    SolverLimits limits;
+    limits.memoryBytes = std::size_t(16) << 20;
+    limits.maxNodes = 200'000;
+    Solver solver(limits);
+    std::vector<double> times;
+    for (uint64_t seed = 1; seed <= 15; ++seed) {
+        Solution solution = solver.solve(dealFromSeed(seed));
+        if (solution.stats.nodes > 0) {
+            times.push_back(solution.stats.seconds * 1e9 /
+                            double(solution.stats.nodes));
+        }
+    }
+    suite.add("solver_node", Summarize(times));
+}
+
+// Everything a frame does apart from drawing: play a move, lay out the
+// piles it touched and pick under the cursor.
+void BenchFrame(Suite& suite) {
+    Game game;
+    game.deal(1);
+    Layout layout;
+    layout.resize(1000, 800);
+    Point positions[CARD_ID_COUNT] = {};
+    layout.refresh(game.state(), positions);
+    const Rect slot = layout.slot(TABLEAU + 3);
+    const Point cursor = {slot.x + 1, slot.y + 1};
+
+    suite.run("frame_headless", [&] {
+        const State& state = game.state();
+        const Move move =
+            state.stockSize() > 0
+                ? Move{STOCK, WASTE, 1}
+                : Move{WASTE, STOCK, state.wasteSize};
+        game.play(move);
+        layout.markDirty(move);
+        layout.refresh(state, positions);
+        benchSink = benchSink + uint64_t(layout.pick(state, cursor).pile);
+    });
+}
+
+void BenchPick(Suite& suite) {
+    for (int count : {1, 7, 13, 19}) {
+        const State state = FannedColumn(count);
+        Layout layout;
+        layout.resize(1000, 800);
+        Point positions[CARD_ID_COUNT] = {};
+        layout.refresh(state, positions);
+
+        // The cursor on the bottom card is the worst case for a scan.
+        const Rect slot = layout.slot(TABLEAU);
+        const Point point = {slot.x + 1, slot.y + 1};
+        const std::string fan = "/" + std::to_string(count);
+        suite.run("pick_index" + fan, [&] {
+            benchSink = benchSink + uint64_t(layout.pick(state, point).index);
+        });
+        suite.run("pick_scan" + fan, [&] {
+            Hit hit = ScanPick(state, layout, positions, point);
+            benchSink = benchSink + uint64_t(hit.index);
+        });
+    }
+}
+
+// One random move in each of a batch of games, legality mask included;
+// timed per game. Finished batches are dealt again from new seeds.
+void BenchBatch(Suite& suite) {
+    constexpr int SIZE = 1024;
+    Batch batch(SIZE);
+    std::vector<uint64_t> seeds(SIZE);
+    std::vector<uint8_t> actions(SIZE);
+    uint64_t nextSeed = 0;
+    auto deal = [&] {
+        for (uint64_t& seed : seeds) seed = nextSeed++;
+        batch.reset(seeds.data());
+    };
+    deal();
+    suite.run(
+        "batch_step",
+        [&] {
+            batch.choose(RANDOM_POLICY, actions.data());
+            if (batch.step(actions.data()) == 0) deal();
+        },
+        SIZE);
+}
+
+// Saving and resuming a game with a long undo log, without the file.
+void BenchSnapshot(Suite& suite) {
+    Game game;
+    game.deal(1);
+    Random random(7);
+    for (int i = 0; i < 300; ++i) {
+        MoveList moves;
+        game.state().legalMoves(moves);
+        if (moves.empty()) break;
+        game.play(moves[int(random.below(uint64_t(moves.size())))]);
+    }
+    SnapshotBuffer buffer;
+    std::size_t size = 0;
+    suite.run("snapshot_encode", [&] {
+        size = encodeSnapshot(game, buffer);
+        benchSink = benchSink + size;
+    });
+    Game restored;
+    suite.run("snapshot_decode", [&] {
+        benchSink = benchSink + decodeSnapshot({buffer.data(), size}, restored);
+    });
+}
+
+// A frame of the deal animation with every card in motion: one tick step
+// and a pose for each of the 52 cards.
+void BenchTweens(Suite& suite) {
+    const State state = dealFromSeed(1);
+    Layout layout;
+    layout.resize(1000, 800);
+    Point positions[CARD_ID_COUNT] = {};
+    layout.refresh(state, positions);
+    const Rect stock = layout.slot(STOCK);
+
+    Tweens tweens;
+    auto deal = [&] {
+        tweens.gather({stock.x - 500, stock.y + 500});
+        tweens.follow(state, positions);
+    };
+    deal();
+    suite.run("tween_frame", [&] {
+        tweens.advance(1.0 / 60);
+        for (int id = 0; id < CARD_ID_COUNT; ++id) {
+            benchSink = benchSink + uint64_t(tweens.pose(id).position.x);
+        }
+        if (!tweens.isAnimating()) deal();
+    });
+}
+
+// Starting a graded deal: attaching to a database of 100k analysed deals
+// and shuffling a random one from a bucket, as the game does at startup.
+void BenchDealDb(Suite& suite) {
+    Random random(11);
+    std::vector<DealRecord> deals(100'000);
+    for (uint64_t seed = 0; seed < deals.size(); ++seed) {
+        const uint64_t roll = random.below(10);
+        deals[seed] = {seed, uint32_t(random.below(1'000'000)),
+                       uint16_t(80 + random.below(120)),
+                       roll < 6 ? SOLVED : roll < 7 ? UNSOLVABLE : GAVE_UP, 0};
+    }
+    const std::vector<uint8_t> bytes = buildDealDb(std::move(deals), 5);
+    suite.run("deal_db_pick", [&] {
+        DealDb db;
+        db.attach(bytes);
+        const int bucket = int(random.below(uint64_t(db.buckets())));
+        const DealRecord deal = db.record(
+            bucket, uint32_t(random.below(db.count(bucket))));
+        benchSink = benchSink + shuffledDeck(deal.seed)[0].bits;
+    });
+}
+
+}  // namespace
+
+// klonkdike_bench [--filter NAME] [--json FILE] [--baseline FILE]
+//                 [--threshold PERCENT]
+// Exits with 1 when anything is slower than the baseline by more than the
+// threshold (10% unless given).
+int main(int argc, char** argv) {
+    Args args(argc - 1, argv + 1);
+    Suite suite;
+    suite.filter = args.get("filter");
+
+    BenchRules(suite);
+    BenchSolver(suite);
+    BenchFrame(suite);
+    BenchPick(suite);
+    BenchBatch(suite);
+    BenchSnapshot(suite);
+    BenchTweens(suite);
+    BenchDealDb(suite);
+    PrintResults(suite.results);
+
+    const std::string json = args.get("json");
+    if (!json.empty() and !WriteJson(json.c_str(), suite.results)) {
+        std::perror(json.c_str());
+        return 2;
+    }
+
+    const std::string baselinePath = args.get("baseline");
+    if (baselinePath.empty()) return 0;
+    std::vector<BenchResult> baseline;
+    if (!ReadJson(baselinePath.c_str(), baseline)) {
+        std::perror(baselinePath.c_str());
+        return 2;
+    }
+    const double threshold = double(args.number("threshold", 10));
+    return CompareWithBaseline(suite.results, baseline, threshold) > 0 ? 1
+                                                                       : 0;
+}
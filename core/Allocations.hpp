@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+
+namespace klondike {
+
+// Heap allocations made through operator new by the calling thread so far.
+// Per thread, so worker threads (the background solver, image decoding)
+// never show up in a count taken on the main thread. Only counted in debug
+// builds (DEBUG defined); release builds return 0.
+uint64_t allocationCount();
+
+constexpr bool COUNTS_ALLOCATIONS =
+#ifdef DEBUG
+    true;
+#else
+    false;
+#endif
+
+// Allocations made by this thread since construction.
+class AllocationScope {
+   public:
+    AllocationScope() : start_(allocationCount()) {}
+    uint64_t count() const { return allocationCount() - start_; }
+
+   private:
+    uint64_t start_;
+};
+
+}  // namespace klondike
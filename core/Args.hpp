@@ -0,0 +1,59 @@
+#pragma once
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// `--name value` and `--flag` parsing shared by the subcommands. Anything
+// not starting with "--" is positional.
+class Args {
+   public:
+    Args(int argc, char** argv) {
+        for (int i = 0; i < argc; ++i) {
+            std::string_view arg = argv[i];
+            if (arg.substr(0, 2) != "--") {
+                positional_.emplace_back(arg);
+                continue;
+            }
+            std::string value;
+            if (i + 1 < argc and
+                std::string_view(argv[i + 1]).substr(0, 2) != "--") {
+                value = argv[++i];
+            }
+            options_.push_back({std::string(arg.substr(2)), value});
+        }
+    }
+
+    bool has(std::string_view name) const { return find(name) != nullptr; }
+
+    std::string get(std::string_view name, std::string fallback = "") const {
+        const std::string* value = find(name);
+        return value ? *value : fallback;
+    }
+
+    uint64_t number(std::string_view name, uint64_t fallback) const {
+        const std::string* value = find(name);
+        return value and !value->empty()
+                   ? std::strtoull(value->c_str(), nullptr, 0)
+                   : fallback;
+    }
+
+    const std::vector<std::string>& positional() const { return positional_; }
+
+   private:
+    struct Option {
+        std::string name;
+        std::string value;
+    };
+
+    const std::string* find(std::string_view name) const {
+        for (const auto& option : options_) {
+            if (option.name == name) return &option.value;
+        }
+        return nullptr;
+    }
+
+    std::vector<Option> options_;
+    std::vector<std::string> positional_;
+};
@@ -0,0 +1,85 @@
+#include "BackgroundSolver.hpp"
+#include <algorithm>
+
+namespace klondike {
+
+BackgroundSolver::BackgroundSolver(SolverLimits limits)
+    : limits_(limits), solver_([&] {
+          limits.cancel = &cancel_;
+          return limits;
+      }()),
+      worker_([this] { run(); }) {}
+
+BackgroundSolver::~BackgroundSolver() {
+    stopping_.store(true);
+    cancel_.store(true);
+    pending_.fetch_add(1);
+    pending_.notify_one();
+    worker_.join();
+}
+
+uint64_t BackgroundSolver::analyze(const State& state) {
+    requests_.back() = {++positions_, state};
+    requests_.publish();
+    cancel_.store(true, std::memory_order_relaxed);
+    pending_.fetch_add(1, std::memory_order_release);
+    pending_.notify_one();
+    return positions_;
+}
+
+bool BackgroundSolver::poll(Analysis& analysis) {
+    if (!results_.update()) return false;
+    analysis = results_.front();
+    return true;
+}
+
+void BackgroundSolver::run() {
+    uint64_t seen = 0;
+    uint64_t finished = 0;
+    for (;;) {
+        pending_.wait(seen, std::memory_order_acquire);
+        seen = pending_.load(std::memory_order_acquire);
+        if (stopping_.load()) return;
+
+        // A cancel raised for a position that is picked up right here
+        // stops that one search early; `pending_` has moved on by then, so
+        // it is simply started again on the next turn of the loop.
+        cancel_.store(false);
+        requests_.update();
+        const Request& request = requests_.front();
+        if (request.position == finished) continue;
+        search(request);
+        if (!cancel_.load()) finished = request.position;
+    }
+}
+
+void BackgroundSolver::search(const Request& request) {
+    Analysis analysis;
+    analysis.position = request.position;
+    const auto begin = std::chrono::steady_clock::now();
+    for (uint64_t budget = FIRST_PASS_NODES;; budget *= 2) {
+        solver_.setMaxNodes(std::min(budget, limits_.maxNodes));
+        Solution solution = solver_.solve(request.state);
+        if (cancel_.load()) return;
+
+        analysis.verdict = solution.verdict;
+        analysis.hasMove = solution.verdict == SOLVED and
+                           !solution.moves.empty();
+        if (analysis.hasMove) analysis.bestMove = solution.moves.front();
+        analysis.nodes += solution.stats.nodes;
+        analysis.seconds = std::chrono::duration<double>(
+                               std::chrono::steady_clock::now() - begin)
+                               .count();
+        results_.back() = analysis;
+        results_.publish();
+
+        const bool outOfTime = limits_.maxSeconds > 0 and
+                               analysis.seconds >= limits_.maxSeconds;
+        if (solution.verdict != GAVE_UP or budget >= limits_.maxNodes or
+            outOfTime) {
+            return;
+        }
+    }
+}
+
+}  // namespace klondike
@@ -0,0 +1,65 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include "Klondike.hpp"
+#include "Solver.hpp"
+#include "TripleBuffer.hpp"
+
+namespace klondike {
+
+// What the background search knows about one position so far.
+struct Analysis {
+    uint64_t position = 0;  // as returned by BackgroundSolver::analyze
+    Verdict verdict = GAVE_UP;
+    bool hasMove = false;  // only once a win has been found
+    Move bestMove = {};
+    uint64_t nodes = 0;  // over every pass so far
+    double seconds = 0;
+};
+
+// Searches the latest position on a thread of its own. Each pass doubles the
+// node budget of the one before, and every pass's verdict is published,
+// so there is an answer soon and a better one later. Searching stops at
+// a verdict, or when the budget in `limits` (nodes, seconds) is spent.
+//
+// Neither call ever blocks: positions go in and results come out through
+// TripleBuffer mailboxes, and a new position cancels the search in flight.
+class BackgroundSolver {
+   public:
+    explicit BackgroundSolver(SolverLimits limits);
+    ~BackgroundSolver();
+
+    BackgroundSolver(const BackgroundSolver&) = delete;
+    BackgroundSolver& operator=(const BackgroundSolver&) = delete;
+
+    // Starts on `state`, dropping whatever was being searched. Returns the
+    // number results for it will carry.
+    uint64_t analyze(const State& state);
+    // True if a result newer than the last one polled has arrived.
+    bool poll(Analysis& analysis);
+
+   private:
+    struct Request {
+        uint64_t position = 0;
+        State state = {};
+    };
+
+    static constexpr uint64_t FIRST_PASS_NODES = 20'000;
+
+    void run();
+    // Returns early, publishing nothing more, once cancelled.
+    void search(const Request& request);
+
+    SolverLimits limits_;
+    Solver solver_;
+    TripleBuffer<Request> requests_;
+    TripleBuffer<Analysis> results_;
+    uint64_t positions_ = 0;  // main thread only
+    std::atomic<uint64_t> pending_{0};
+    std::atomic<bool> cancel_{false};
+    std::atomic<bool> stopping_{false};
+    std::thread worker_;
+};
+
+}  // namespace klondike
@@ -0,0 +1,364 @@
+#include "Batch.hpp"
+#include <cstring>
+#include "Solver.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define KLONDIKE_BATCH_SSE2 1
+#endif
+
+namespace klondike {
+
+namespace {
+
+constexpr int LANES = 16;
+
+// The actions that can ever be legal: off the tableau or the waste onto a
+// column or a home cell, plus drawing and recycling. Rows of the mask for
+// the rest are zeroed once and never written.
+struct Candidates {
+    uint8_t actions[ACTION_COUNT];
+    int size;
+};
+
+constexpr Candidates CANDIDATES = [] {
+    Candidates candidates = {};
+    for (int from = 0; from <= WASTE; ++from) {
+        for (int to = 0; to < PILE_COUNT; ++to) {
+            const bool onto = isTableau(to) ? to != from : isFoundation(to);
+            if (from != STOCK and onto) {
+                candidates.actions[candidates.size++] = actionOf(from, to);
+            }
+        }
+    }
+    candidates.actions[candidates.size++] = actionOf(STOCK, WASTE);
+    candidates.actions[candidates.size++] = actionOf(WASTE, STOCK);
+    return candidates;
+}();
+
+// The pile rows of 16 games that one action's mask is computed from.
+struct Lanes {
+    const uint8_t* value;
+    const uint8_t* suit;
+    const uint8_t* color;
+    const uint8_t* size;
+    const uint8_t* run;
+};
+
+// Each kernel writes the mask for 16 games of one action; it mirrors a
+// case of State::isLegal. Face-up runs are built down in alternating
+// colours, so the card of a run that fits a column is found from the
+// run's top value, and its colour is the top's flipped once per card.
+#ifdef KLONDIKE_BATCH_SSE2
+
+__m128i Load(const uint8_t* row) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(row));
+}
+
+void Store(uint8_t* row, __m128i value) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(row), value);
+}
+
+void ToColumn(const Lanes& from, const Lanes& to, const uint8_t* live,
+              uint8_t* mask) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi8(1);
+    const __m128i king = _mm_set1_epi8(KING);
+    const __m128i empty = _mm_cmpeq_epi8(Load(to.size), zero);
+    const __m128i below = _mm_sub_epi8(Load(to.value), one);
+    const __m128i wanted = _mm_or_si128(_mm_and_si128(empty, king),
+                                        _mm_andnot_si128(empty, below));
+    // Below the run top or past its end both come out as run - depth
+    // saturating to 0.
+    const __m128i depth = _mm_sub_epi8(wanted, Load(from.value));
+    const __m128i outside =
+        _mm_cmpeq_epi8(_mm_subs_epu8(Load(from.run), depth), zero);
+    const __m128i colors = _mm_and_si128(
+        _mm_xor_si128(_mm_xor_si128(Load(from.color), Load(to.color)), depth),
+        one);
+    const __m128i fits = _mm_or_si128(empty, _mm_cmpeq_epi8(colors, one));
+    const __m128i legal =
+        _mm_and_si128(_mm_andnot_si128(outside, fits), Load(live));
+    Store(mask, _mm_and_si128(_mm_add_epi8(depth, one), legal));
+}
+
+void ToHome(const Lanes& from, int suit, const uint8_t* homeValue,
+            const uint8_t* live, uint8_t* mask) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi8(1);
+    const __m128i legal = _mm_and_si128(
+        _mm_andnot_si128(_mm_cmpeq_epi8(Load(from.run), zero),
+                         _mm_cmpeq_epi8(Load(from.suit),
+                                        _mm_set1_epi8(char(suit)))),
+        _mm_cmpeq_epi8(Load(from.value),
+                       _mm_add_epi8(Load(homeValue), one)));
+    Store(mask, _mm_and_si128(_mm_and_si128(legal, Load(live)), one));
+}
+
+void Talon(const uint8_t* stock, const uint8_t* waste, const uint8_t* live,
+           uint8_t* drawMask, uint8_t* recycleMask) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i stockEmpty = _mm_cmpeq_epi8(Load(stock), zero);
+    const __m128i playing = Load(live);
+    Store(drawMask, _mm_and_si128(_mm_andnot_si128(stockEmpty, playing),
+                                  _mm_set1_epi8(1)));
+    Store(recycleMask,
+          _mm_and_si128(_mm_and_si128(stockEmpty, playing), Load(waste)));
+}
+
+#else
+
+void ToColumn(const Lanes& from, const Lanes& to, const uint8_t* live,
+              uint8_t* mask) {
+    for (int i = 0; i < LANES; ++i) {
+        const bool empty = to.size[i] == 0;
+        const int wanted = empty ? KING : to.value[i] - 1;
+        const int depth = wanted - from.value[i];
+        const bool fits =
+            empty or ((from.color[i] ^ to.color[i] ^ depth) & 1) != 0;
+        const bool legal = live[i] and depth >= 0 and depth < from.run[i] and
+                           fits;
+        mask[i] = static_cast<uint8_t>(legal ? depth + 1 : 0);
+    }
+}
+
+void ToHome(const Lanes& from, int suit, const uint8_t* homeValue,
+            const uint8_t* live, uint8_t* mask) {
+    for (int i = 0; i < LANES; ++i) {
+        mask[i] = live[i] and from.run[i] > 0 and from.suit[i] == suit and
+                  from.value[i] == homeValue[i] + 1;
+    }
+}
+
+void Talon(const uint8_t* stock, const uint8_t* waste, const uint8_t* live,
+           uint8_t* drawMask, uint8_t* recycleMask) {
+    for (int i = 0; i < LANES; ++i) {
+        drawMask[i] = live[i] and stock[i] > 0;
+        recycleMask[i] = (live[i] and stock[i] == 0) ? waste[i] : 0;
+    }
+}
+
+#endif
+
+}  // namespace
+
+Batch::Batch(int size, int maxMoves)
+    : size_(size),
+      stride_((size + LANES - 1) / LANES * LANES),
+      maxMoves_(maxMoves),
+      states_(std::size_t(size)),
+      moves_(std::size_t(size)),
+      status_(std::size_t(size), BATCH_STUCK) {
+    const auto rows = std::size_t(PILE_COUNT * stride_);
+    for (auto* pile : {&value_, &suit_, &color_, &sizes_, &run_}) {
+        pile->assign(rows, 0);
+    }
+    live_.assign(std::size_t(stride_), 0);
+    counts_.assign(std::size_t(stride_), 0);
+    picks_.assign(std::size_t(stride_), 0);
+    mask_.assign(std::size_t(ACTION_COUNT * stride_), 0);
+}
+
+void Batch::reset(const uint64_t* seeds) {
+    random_.clear();
+    random_.reserve(std::size_t(size_));
+    for (int game = 0; game < size_; ++game) {
+        states_[game] = dealFromSeed(seeds[game]);
+        random_.emplace_back(seeds[game]);
+        moves_[game] = 0;
+        status_[game] = BATCH_PLAYING;
+        live_[game] = 0xFF;
+        for (int pile = 0; pile < PILE_COUNT; ++pile) refreshPile(game, pile);
+    }
+    maskFresh_ = false;
+}
+
+void Batch::refreshPile(int game, int pile) {
+    const State& state = states_[game];
+    if (isFoundation(pile)) {
+        row(value_, pile)[game] = state.foundation[pile - FOUNDATION];
+        return;
+    }
+    const int size = pile == STOCK ? state.stockSize() : state.pileSize(pile);
+    const Card top = size > 0 ? state.top(pile) : Card{0};
+    int run = 0;
+    if (pile == WASTE) {
+        run = size > 0;
+    } else if (isTableau(pile)) {
+        const auto cards = state.column(pile);
+        while (run < size and cards[size - 1 - run].isFaceUp()) ++run;
+    }
+    row(value_, pile)[game] = static_cast<uint8_t>(top.value());
+    row(suit_, pile)[game] = static_cast<uint8_t>(top.suit());
+    row(color_, pile)[game] = static_cast<uint8_t>(colorOf(top));
+    row(sizes_, pile)[game] = static_cast<uint8_t>(size);
+    row(run_, pile)[game] = static_cast<uint8_t>(run);
+}
+
+// Writes every CANDIDATES row; the others were zeroed at construction.
+void Batch::computeMask() {
+    auto lanes = [&](int pile, int game) {
+        const std::size_t at = std::size_t(pile * stride_ + game);
+        return Lanes{value_.data() + at, suit_.data() + at,
+                     color_.data() + at, sizes_.data() + at, run_.data() + at};
+    };
+    auto maskAt = [&](int from, int to, int game) {
+        return mask_.data() + actionOf(from, to) * stride_ + game;
+    };
+
+    for (int game = 0; game < stride_; game += LANES) {
+        const uint8_t* live = live_.data() + game;
+        for (int from = 0; from <= WASTE; ++from) {
+            if (from == STOCK) continue;
+            const Lanes source = lanes(from, game);
+            for (int to = TABLEAU; to < TABLEAU + TABLEAU_COUNT; ++to) {
+                if (to != from) {
+                    ToColumn(source, lanes(to, game), live,
+                             maskAt(from, to, game));
+                }
+            }
+            for (int suit = 0; suit < SUIT_COUNT; ++suit) {
+                const int home = FOUNDATION + suit;
+                ToHome(source, suit, row(value_, home) + game, live,
+                       maskAt(from, home, game));
+            }
+        }
+        Talon(row(sizes_, STOCK) + game, row(sizes_, WASTE) + game, live,
+              maskAt(STOCK, WASTE, game), maskAt(WASTE, STOCK, game));
+    }
+
+    // A game with nothing legal is over. OR-ing the rows together keeps
+    // this a sweep over contiguous bytes.
+    uint8_t* any = counts_.data();
+    const int stride = stride_;
+    std::memset(any, 0, counts_.size());
+    for (int i = 0; i < CANDIDATES.size; ++i) {
+        const uint8_t* mask = mask_.data() + CANDIDATES.actions[i] * stride;
+        for (int game = 0; game < stride; ++game) any[game] |= mask[game];
+    }
+    for (int game = 0; game < size_; ++game) {
+        if (live_[game] and !any[game]) {
+            status_[game] = BATCH_STUCK;
+            live_[game] = 0;
+        }
+    }
+    maskFresh_ = true;
+}
+
+const uint8_t* Batch::legalMask() {
+    if (!maskFresh_) computeMask();
+    return mask_.data();
+}
+
+int Batch::step(const uint8_t* actions) {
+    const uint8_t* mask = legalMask();
+    int playing = 0;
+    for (int game = 0; game < size_; ++game) {
+        const uint8_t action = actions[game];
+        if (status_[game] == BATCH_PLAYING and action < ACTION_COUNT) {
+            const uint8_t count = mask[action * stride_ + game];
+            if (count > 0) {
+                const Move move = {uint8_t(action / PILE_COUNT),
+                                   uint8_t(action % PILE_COUNT), count};
+                State& state = states_[game];
+                state.apply(move);
+                refreshPile(game, move.from);
+                refreshPile(game, move.to);
+
+                if (state.isWon()) {
+                    status_[game] = BATCH_WON;
+                } else if (++moves_[game] >= maxMoves_) {
+                    status_[game] = BATCH_OUT_OF_MOVES;
+                }
+                if (status_[game] != BATCH_PLAYING) live_[game] = 0;
+            }
+        }
+        playing += status_[game] == BATCH_PLAYING;
+    }
+    maskFresh_ = false;
+    return playing;
+}
+
+void Batch::choose(BatchPolicy policy, uint8_t* actions) {
+    legalMask();
+    std::memset(actions, NO_ACTION, std::size_t(size_));
+    if (policy == SOLVER_POLICY) {
+        for (int game = 0; game < size_; ++game) {
+            const int action = pickBySolver(game);
+            if (action >= 0) actions[game] = uint8_t(action);
+        }
+    } else if (policy == GREEDY_POLICY) {
+        pickRandom(actions, true);
+    }
+    pickRandom(actions, false);
+}
+
+// Gives every game still on NO_ACTION a uniformly random legal action, or
+// one to a home cell if `homeOnly`. The mask is walked a row at a time,
+// counting legal actions per game and then counting down to the one
+// picked, so the loops are branch-free and read contiguous bytes.
+void Batch::pickRandom(uint8_t* actions, bool homeOnly) {
+    // Raw pointers so the compiler can keep them in registers and
+    // vectorize the loops.
+    uint8_t* counts = counts_.data();
+    uint8_t* picks = picks_.data();
+    const int games = size_;
+
+    std::memset(counts, 0, counts_.size());
+    for (int i = 0; i < CANDIDATES.size; ++i) {
+        const int action = CANDIDATES.actions[i];
+        if (homeOnly and !isFoundation(action % PILE_COUNT)) continue;
+        const uint8_t* mask = mask_.data() + action * stride_;
+        for (int game = 0; game < games; ++game) {
+            counts[game] = uint8_t(counts[game] + (mask[game] != 0));
+        }
+    }
+    // Games that are not picking start on 0xFF and, with fewer than 255
+    // legal actions, never count down to 0.
+    for (int game = 0; game < games; ++game) {
+        const bool open = actions[game] == NO_ACTION and counts[game] > 0;
+        picks[game] = open ? uint8_t(random_[game].below(counts[game])) : 0xFF;
+    }
+    for (int i = 0; i < CANDIDATES.size; ++i) {
+        const uint8_t action = CANDIDATES.actions[i];
+        if (homeOnly and !isFoundation(action % PILE_COUNT)) continue;
+        const uint8_t* mask = mask_.data() + action * stride_;
+        for (int game = 0; game < games; ++game) {
+            const uint8_t legal = mask[game] != 0;
+            actions[game] = legal and picks[game] == 0 ? action : actions[game];
+            picks[game] = uint8_t(picks[game] - legal);
+        }
+    }
+}
+
+// What the solver would try first: a card that can safely go home, else
+// the legal move Solver::priority likes best, ties broken at random. -1 if
+// it would try nothing.
+int Batch::pickBySolver(int game) {
+    const State& state = states_[game];
+    int best = -1;
+    int bestScore = -1;
+    uint32_t ties = 0;
+    for (int i = 0; i < CANDIDATES.size; ++i) {
+        const int action = CANDIDATES.actions[i];
+        const uint8_t count = mask_[std::size_t(action * stride_ + game)];
+        if (count == 0) continue;
+        const Move move = {uint8_t(action / PILE_COUNT),
+                           uint8_t(action % PILE_COUNT), count};
+        if (isFoundation(move.to) and
+            Solver::isSafeToFound(state, state.top(move.from))) {
+            return action;
+        }
+        const int score = Solver::priority(state, move);
+        if (score > bestScore) {
+            bestScore = score;
+            best = action;
+            ties = 1;
+        } else if (score == bestScore and random_[game].below(++ties) == 0) {
+            best = action;
+        }
+    }
+    return best;
+}
+
+}  // namespace klondike
@@ -0,0 +1,102 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Klondike.hpp"
+#include "Random.hpp"
+
+namespace klondike {
+
+// Actions in a batch are pile pairs, from * PILE_COUNT + to. Klondike never
+// allows two counts between the same two piles, so the pair is the move.
+constexpr int ACTION_COUNT = PILE_COUNT * PILE_COUNT;
+constexpr uint8_t NO_ACTION = 0xFF;
+
+constexpr uint8_t actionOf(int from, int to) {
+    return static_cast<uint8_t>(from * PILE_COUNT + to);
+}
+
+enum BatchStatus : uint8_t {
+    BATCH_PLAYING,
+    BATCH_WON,
+    BATCH_STUCK,         // no legal move left
+    BATCH_OUT_OF_MOVES,  // hit the move limit, usually cycling the stock
+};
+
+enum BatchPolicy {
+    RANDOM_POLICY,  // uniform over the legal actions
+    GREEDY_POLICY,  // anything to a home cell first, otherwise random
+    SOLVER_POLICY,  // safe home moves, then the solver's move ordering
+};
+
+// Many games stepped together, one move each per step(), for simulation
+// and training. Draw one, unlimited passes (SolverRules).
+//
+// What legality depends on (top card, size and face-up run of each pile)
+// is kept structure-of-arrays: one row per pile, one byte per game, so
+// legalMask() works out a pile pair for 16 games per SSE2 instruction.
+// The cards themselves stay as one State per game, which is what apply()
+// needs and is only touched by the games a step moves.
+class Batch {
+   public:
+    // Games beyond `maxMoves` moves are stopped as BATCH_OUT_OF_MOVES.
+    explicit Batch(int size, int maxMoves = 1000);
+
+    int size() const { return size_; }
+    // Games per row of the mask: size() rounded up to a multiple of 16.
+    int stride() const { return stride_; }
+
+    // Deals seeds[i] to game i, for all size() games.
+    void reset(const uint64_t* seeds);
+
+    // For every action and game, the cards the action would move, or 0 if
+    // it is illegal: mask[action * stride() + game]. Finished games have
+    // no legal actions. Valid until the next step() or reset().
+    const uint8_t* legalMask();
+
+    // Plays actions[i] in game i. NO_ACTION, illegal actions and finished
+    // games are left alone. Returns the number of games still playing.
+    int step(const uint8_t* actions);
+
+    // Fills actions[] for every game from the current mask.
+    void choose(BatchPolicy policy, uint8_t* actions);
+
+    const uint8_t* status() const { return status_.data(); }
+    const State& state(int game) const { return states_[game]; }
+    int moves(int game) const { return moves_[game]; }
+
+   private:
+    uint8_t* row(std::vector<uint8_t>& rows, int pile) {
+        return rows.data() + pile * stride_;
+    }
+    void refreshPile(int game, int pile);
+    void computeMask();
+    void pickRandom(uint8_t* actions, bool homeOnly);
+    int pickBySolver(int game);
+
+    int size_;
+    int stride_;
+    int maxMoves_;
+
+    std::vector<State> states_;
+    std::vector<Random> random_;
+    std::vector<int> moves_;  // as wide as maxMoves_, so any limit is reached
+    std::vector<uint8_t> status_;
+
+    // PILE_COUNT rows of stride_ bytes each. value_ is 0 for an empty pile;
+    // for a home cell it is the top value and the other rows are unused.
+    std::vector<uint8_t> value_;
+    std::vector<uint8_t> suit_;
+    std::vector<uint8_t> color_;
+    std::vector<uint8_t> sizes_;
+    std::vector<uint8_t> run_;
+    // One row: 0xFF for a game still playing, so finished games mask to 0.
+    std::vector<uint8_t> live_;
+
+    std::vector<uint8_t> mask_;  // ACTION_COUNT rows of stride_ bytes
+    // Scratch rows for finding stuck games and picking random actions.
+    std::vector<uint8_t> counts_;
+    std::vector<uint8_t> picks_;
+    bool maskFresh_ = false;
+};
+
+}  // namespace klondike
@@ -0,0 +1,49 @@
+#include "BatchApi.h"
+#include "Batch.hpp"
+
+using klondike::Batch;
+
+// The C handle is the Batch itself.
+struct kd_batch : Batch {
+    using Batch::Batch;
+};
+
+static_assert(KD_PILE_COUNT == klondike::PILE_COUNT);
+static_assert(KD_ACTION_COUNT == klondike::ACTION_COUNT);
+static_assert(KD_NO_ACTION == klondike::NO_ACTION);
+static_assert(KD_OUT_OF_MOVES == klondike::BATCH_OUT_OF_MOVES);
+static_assert(KD_SOLVER_POLICY == klondike::SOLVER_POLICY);
+
+kd_batch* kd_batch_create(int size, int max_moves) {
+    if (size <= 0 or max_moves <= 0) return nullptr;
+    return new kd_batch(size, max_moves);
+}
+
+void kd_batch_destroy(kd_batch* batch) { delete batch; }
+
+int kd_batch_size(const kd_batch* batch) { return batch->size(); }
+
+int kd_batch_stride(const kd_batch* batch) { return batch->stride(); }
+
+void kd_batch_reset(kd_batch* batch, const uint64_t* seeds) {
+    batch->reset(seeds);
+}
+
+const uint8_t* kd_batch_legal_mask(kd_batch* batch) {
+    return batch->legalMask();
+}
+
+int kd_batch_step(kd_batch* batch, const uint8_t* actions) {
+    return batch->step(actions);
+}
+
+void kd_batch_choose(kd_batch* batch, int policy, uint8_t* actions) {
+    if (policy < klondike::RANDOM_POLICY or policy > klondike::SOLVER_POLICY) {
+        policy = klondike::RANDOM_POLICY;
+    }
+    batch->choose(klondike::BatchPolicy(policy), actions);
+}
+
+const uint8_t* kd_batch_status(const kd_batch* batch) {
+    return batch->status();
+}
@@ -0,0 +1,66 @@
+#pragma once
+/* C interface to klondike::Batch (Batch.hpp), for driving batches of games
+ * from C or through an FFI. The klonkdike_batch shared library exports
+ * these functions and nothing else. Buffers returned here belong to the
+ * batch and are read in place; nothing is copied per step. */
+#include <stdint.h>
+
+#if defined(_WIN32) && defined(KD_BUILD_SHARED)
+#define KD_API __declspec(dllexport)
+#elif defined(__GNUC__)
+#define KD_API __attribute__((visibility("default")))
+#else
+#define KD_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct kd_batch kd_batch;
+
+/* Actions are from_pile * KD_PILE_COUNT + to_pile; the pile numbers are
+ * klondike's (tableau 0-6, stock 7, waste 8, home cells 9-12). */
+#define KD_PILE_COUNT 13
+#define KD_ACTION_COUNT (KD_PILE_COUNT * KD_PILE_COUNT)
+#define KD_NO_ACTION 0xFF
+
+/* Values of kd_batch_status(). */
+#define KD_PLAYING 0
+#define KD_WON 1
+#define KD_STUCK 2
+#define KD_OUT_OF_MOVES 3
+
+/* Policies for kd_batch_choose(). */
+#define KD_RANDOM_POLICY 0
+#define KD_GREEDY_POLICY 1
+#define KD_SOLVER_POLICY 2
+
+KD_API kd_batch* kd_batch_create(int size, int max_moves);
+KD_API void kd_batch_destroy(kd_batch* batch);
+
+KD_API int kd_batch_size(const kd_batch* batch);
+/* Games per mask row: the size rounded up to a multiple of 16. */
+KD_API int kd_batch_stride(const kd_batch* batch);
+
+/* Deals seeds[i] to game i; `seeds` holds kd_batch_size() values. */
+KD_API void kd_batch_reset(kd_batch* batch, const uint64_t* seeds);
+
+/* Cards each action would move, 0 when illegal, at
+ * mask[action * kd_batch_stride() + game]. Valid until the next step or
+ * reset. */
+KD_API const uint8_t* kd_batch_legal_mask(kd_batch* batch);
+
+/* Plays actions[i] in game i and returns how many games are still
+ * playing. KD_NO_ACTION and illegal actions leave a game as it is. */
+KD_API int kd_batch_step(kd_batch* batch, const uint8_t* actions);
+
+/* Fills actions[] (kd_batch_size() bytes) with the policy's choices. */
+KD_API void kd_batch_choose(kd_batch* batch, int policy, uint8_t* actions);
+
+/* One KD_* status byte per game. */
+KD_API const uint8_t* kd_batch_status(const kd_batch* batch);
+
+#ifdef __cplusplus
+}
+#endif
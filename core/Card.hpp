@@ -0,0 +1,84 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+namespace klondike {
+
+enum Suit { HEARTS, CLUBS, DIAMONDS, SPADES };
+
+constexpr int SUIT_COUNT = 4;
+constexpr int RANK_COUNT = 13;
+constexpr int DECK_SIZE = SUIT_COUNT * RANK_COUNT;
+constexpr int KING = 13;
+// Card ids are (suit << 4) | value, so they fit in 6 bits but are sparse.
+constexpr int CARD_ID_COUNT = 64;
+
+// One byte per card: bits 0-3 value (1..13), bits 4-5 suit, bit 6 face up.
+// The rules only ever need these; textures and screen positions live in the
+// game's view layer, keyed by id().
+struct Card {
+    uint8_t bits;
+
+    static constexpr uint8_t VALUE_MASK = 0x0F;
+    static constexpr uint8_t ID_MASK = 0x3F;
+    static constexpr uint8_t FACE_UP = 0x40;
+
+    static constexpr Card make(Suit suit, int value, bool isFaceUp = false) {
+        return {static_cast<uint8_t>((suit << 4) | value |
+                                     (isFaceUp ? FACE_UP : 0))};
+    }
+
+    constexpr int id() const { return bits & ID_MASK; }
+    constexpr Suit suit() const { return static_cast<Suit>((bits >> 4) & 3); }
+    constexpr int value() const { return bits & VALUE_MASK; }
+    constexpr bool isFaceUp() const { return bits & FACE_UP; }
+
+    constexpr Card faceUp() const {
+        return {static_cast<uint8_t>(bits | FACE_UP)};
+    }
+    constexpr Card faceDown() const {
+        return {static_cast<uint8_t>(bits & ID_MASK)};
+    }
+
+    constexpr bool operator==(const Card&) const = default;
+};
+
+static_assert(sizeof(Card) == 1);
+
+constexpr bool isRed(Suit suit) { return suit == HEARTS or suit == DIAMONDS; }
+
+// Colour of every card id (1 for red), worked out at compile time so the
+// rule checks below are a table lookup and a compare.
+constexpr auto CARD_COLORS = [] {
+    std::array<uint8_t, CARD_ID_COUNT> colors = {};
+    for (int id = 0; id < CARD_ID_COUNT; ++id) {
+        colors[id] = isRed(static_cast<Suit>((id >> 4) & 3));
+    }
+    return colors;
+}();
+
+constexpr int colorOf(Card card) { return CARD_COLORS[card.id()]; }
+
+// Red goes on black and black goes on red.
+constexpr bool suitReliable(Card card, Card target) {
+    return colorOf(card) != colorOf(target);
+}
+
+// Tableau rule: one rank lower and of the opposite colour.
+constexpr bool canStack(Card card, Card target) {
+    return target.value() - card.value() == 1 and suitReliable(card, target);
+}
+
+// Only a king may be moved into an empty column.
+constexpr bool canStartColumn(Card card) { return card.value() == KING; }
+
+// Foundations are built up by suit from the ace; `topValue` is 0 when empty.
+constexpr bool canFound(Card card, int topValue) {
+    return card.value() == topValue + 1;
+}
+
+static_assert(canStack(Card::make(SPADES, 6), Card::make(HEARTS, 7)));
+static_assert(!canStack(Card::make(CLUBS, 6), Card::make(SPADES, 7)));
+static_assert(!canStack(Card::make(DIAMONDS, 7), Card::make(HEARTS, 7)));
+
+}  // namespace klondike
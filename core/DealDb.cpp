@@ -0,0 +1,151 @@
+#include "DealDb.hpp"
+#include <algorithm>
+#include <cassert>
+
+namespace klondike {
+
+namespace {
+
+constexpr uint8_t MAGIC[3] = {'K', 'D', 'D'};
+
+void PutLittleEndian(uint8_t* out, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; ++i) {
+        out[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+uint64_t GetLittleEndian(const uint8_t* in, int bytes) {
+    uint64_t value = 0;
+    for (int i = bytes - 1; i >= 0; --i) value = value << 8 | in[i];
+    return value;
+}
+
+std::size_t HeaderSize(int buckets) {
+    return 8 + 4 * std::size_t(buckets + 3);
+}
+
+}  // namespace
+
+std::vector<uint8_t> buildDealDb(std::vector<DealRecord> deals, int buckets) {
+    assert(buckets >= 1 and buckets <= DEAL_DB_MAX_BUCKETS);
+
+    // Ranked by difficulty first to share out the buckets...
+    std::vector<DealRecord*> solved;
+    for (DealRecord& deal : deals) {
+        if (deal.verdict == SOLVED) {
+            solved.push_back(&deal);
+        } else {
+            deal.group = uint8_t(deal.verdict == UNSOLVABLE ? buckets
+                                                             : buckets + 1);
+        }
+    }
+    std::sort(solved.begin(), solved.end(),
+              [](const DealRecord* a, const DealRecord* b) {
+                  if (a->nodes != b->nodes) return a->nodes < b->nodes;
+                  if (a->moves != b->moves) return a->moves < b->moves;
+                  return a->seed < b->seed;
+              });
+    for (std::size_t rank = 0; rank < solved.size(); ++rank) {
+        solved[rank]->group =
+            uint8_t(rank * std::size_t(buckets) / solved.size());
+    }
+    // ...then laid out by group and seed.
+    std::sort(deals.begin(), deals.end(),
+              [](const DealRecord& a, const DealRecord& b) {
+                  if (a.group != b.group) return a.group < b.group;
+                  return a.seed < b.seed;
+              });
+
+    std::vector<uint8_t> bytes(HeaderSize(buckets) +
+                               deals.size() * DEAL_RECORD_SIZE);
+    uint8_t* out = bytes.data();
+    out[0] = MAGIC[0];
+    out[1] = MAGIC[1];
+    out[2] = MAGIC[2];
+    out[3] = DEAL_DB_VERSION;
+    out[4] = uint8_t(buckets);
+
+    std::size_t next = 0;
+    for (int group = 0; group <= buckets + 2; ++group) {
+        while (next < deals.size() and deals[next].group < group) ++next;
+        PutLittleEndian(out + 8 + 4 * group, next, 4);
+    }
+
+    uint8_t* record = out + HeaderSize(buckets);
+    for (const DealRecord& deal : deals) {
+        PutLittleEndian(record, deal.seed, 8);
+        PutLittleEndian(record + 8, deal.nodes, 4);
+        PutLittleEndian(record + 12, deal.moves, 2);
+        record[14] = uint8_t(deal.verdict);
+        record[15] = deal.group;
+        record += DEAL_RECORD_SIZE;
+    }
+    return bytes;
+}
+
+bool DealDb::attach(std::span<const uint8_t> bytes) {
+    *this = {};
+    if (bytes.size() < 8 or bytes[0] != MAGIC[0] or bytes[1] != MAGIC[1] or
+        bytes[2] != MAGIC[2] or bytes[3] != DEAL_DB_VERSION) {
+        return false;
+    }
+    const int buckets = bytes[4];
+    if (buckets < 1 or buckets > DEAL_DB_MAX_BUCKETS or bytes[5] != 0 or
+        bytes[6] != 0 or bytes[7] != 0 or bytes.size() < HeaderSize(buckets)) {
+        return false;
+    }
+
+    uint32_t starts[DEAL_DB_MAX_BUCKETS + 3];
+    for (int group = 0; group <= buckets + 2; ++group) {
+        starts[group] = uint32_t(GetLittleEndian(&bytes[8 + 4 * group], 4));
+        if (group == 0 ? starts[0] != 0 : starts[group] < starts[group - 1]) {
+            return false;
+        }
+    }
+    const std::span<const uint8_t> records =
+        bytes.subspan(HeaderSize(buckets));
+    if (records.size() != starts[buckets + 2] * DEAL_RECORD_SIZE) {
+        return false;
+    }
+
+    records_ = records;
+    buckets_ = buckets;
+    std::copy(starts, starts + buckets + 3, starts_);
+    return true;
+}
+
+DealRecord DealDb::at(uint32_t index) const {
+    const uint8_t* in = &records_[index * DEAL_RECORD_SIZE];
+    return {GetLittleEndian(in, 8), uint32_t(GetLittleEndian(in + 8, 4)),
+            uint16_t(GetLittleEndian(in + 12, 2)),
+            in[14] <= GAVE_UP ? Verdict(in[14]) : GAVE_UP, in[15]};
+}
+
+DealRecord DealDb::record(int group, uint32_t index) const {
+    assert(group >= 0 and group < buckets_ + 2 and index < count(group));
+    return at(starts_[group] + index);
+}
+
+bool DealDb::find(uint64_t seed, DealRecord& record) const {
+    for (int group = 0; group < buckets_ + 2; ++group) {
+        uint32_t low = starts_[group];
+        uint32_t high = starts_[group + 1];
+        while (low < high) {
+            const uint32_t middle = low + (high - low) / 2;
+            const uint64_t found = GetLittleEndian(
+                &records_[middle * DEAL_RECORD_SIZE], 8);
+            if (found == seed) {
+                record = at(middle);
+                return true;
+            }
+            if (found < seed) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+    }
+    return false;
+}
+
+}  // namespace klondike
@@ -0,0 +1,75 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "Solver.hpp"
+
+namespace klondike {
+
+// Deals already put through the solver, so the game can hand out one known
+// to be winnable at a chosen difficulty without solving anything. All
+// little-endian:
+//
+//   0   "KDD", version
+//   4   u8 difficulty buckets B, three zero bytes
+//   8   u32 first record of each of the B + 2 groups, then the record count
+//   ..  the records, DEAL_RECORD_SIZE bytes each, by group and then by seed
+//
+// Groups 0 to B - 1 are the winnable deals, easiest first; group B holds
+// the deals the solver proved unwinnable and B + 1 those it gave up on.
+// A record is a u64 seed, u32 nodes searched (saturating), u16 moves in
+// the solver's line, u8 verdict and u8 group.
+//
+// Difficulty is how many nodes the solver needed, a stand-in for how many
+// choices have to be got right, with the line's length breaking ties.
+// Buckets hold equal shares of the winnable deals.
+constexpr uint8_t DEAL_DB_VERSION = 1;
+constexpr int DEAL_DB_MAX_BUCKETS = 16;
+constexpr std::size_t DEAL_RECORD_SIZE = 16;
+
+struct DealRecord {
+    uint64_t seed;
+    uint32_t nodes;
+    // The length of the line the solver found, which is not necessarily
+    // the shortest.
+    uint16_t moves;
+    Verdict verdict;
+    uint8_t group;
+};
+
+// Buckets the winnable deals by difficulty and lays the file out. The
+// `group` of the records passed in is ignored.
+std::vector<uint8_t> buildDealDb(std::vector<DealRecord> deals, int buckets);
+
+// Reads a deal database held in memory, normally a MappedFile. Nothing is
+// copied; a record is decoded when it is asked for.
+class DealDb {
+   public:
+    // False unless `bytes` has a sound header and exactly the records it
+    // lists. The records themselves are not looked at, so attaching costs
+    // the same however many deals there are.
+    bool attach(std::span<const uint8_t> bytes);
+
+    int buckets() const { return buckets_; }
+    int unwinnableGroup() const { return buckets_; }
+    int undecidedGroup() const { return buckets_ + 1; }
+    uint32_t size() const { return starts_[buckets_ + 2]; }
+
+    uint32_t count(int group) const {
+        return starts_[group + 1] - starts_[group];
+    }
+    // The `index`th deal in `group`, by seed; index < count(group).
+    DealRecord record(int group, uint32_t index) const;
+    // Binary search in every group. False if `seed` is not in the file.
+    bool find(uint64_t seed, DealRecord& record) const;
+
+   private:
+    DealRecord at(uint32_t index) const;
+
+    std::span<const uint8_t> records_;
+    int buckets_ = 0;
+    uint32_t starts_[DEAL_DB_MAX_BUCKETS + 3] = {};
+};
+
+}  // namespace klondike
@@ -0,0 +1,113 @@
+#include "Game.hpp"
+#include "Solver.hpp"
+
+namespace klondike {
+
+void Game::deal(const Deck& deck, uint64_t seed, Variant variant) {
+    withRules(variant, [&](auto rules) {
+        state_.deal<decltype(rules)>(deck);
+    });
+    seed_ = seed;
+    variant_ = variant;
+    history_.clear();
+    moves_.reset(state_, ruleSet(variant));
+    if (recorder_) recorder_->begin(seed, variant);
+}
+
+void Game::restore(const State& state, uint64_t seed, Variant variant,
+                   std::span<const PackedMove> history, int applied) {
+    state_ = state;
+    seed_ = seed;
+    variant_ = variant;
+    history_.assign(history, applied);
+    moves_.reset(state_, ruleSet(variant));
+}
+
+bool Game::play(Move move) {
+    const bool legal = withRules(variant_, [&](auto rules) {
+        using R = decltype(rules);
+        if (!state_.isLegal<R>(move)) return false;
+        history_.push(state_.apply<R>(move));
+        return true;
+    });
+    if (!legal) return false;
+    moves_.update(state_, move);
+    if (recorder_) recorder_->move(move);
+    return true;
+}
+
+bool Game::undo(Move& changed) {
+    if (!history_.canUndo()) return false;
+    const MoveRecord record = history_.undo();
+    withRules(variant_, [&](auto rules) {
+        state_.undo<decltype(rules)>(record);
+    });
+    changed = record.move;
+    moves_.update(state_, changed);
+    if (recorder_) recorder_->undo();
+    return true;
+}
+
+bool Game::redo(Move& changed) {
+    if (!history_.canRedo()) return false;
+    changed = history_.redo().move;
+    withRules(variant_, [&](auto rules) {
+        state_.apply<decltype(rules)>(changed);
+    });
+    moves_.update(state_, changed);
+    if (recorder_) recorder_->redo();
+    return true;
+}
+
+bool Game::play(const ReplayEvent& event, Move& changed) {
+    switch (event.kind) {
+        case MOVE_EVENT:
+            changed = event.move;
+            return play(event.move);
+        case UNDO_EVENT:
+            return undo(changed);
+        case REDO_EVENT:
+            return redo(changed);
+    }
+    return false;
+}
+
+bool Game::hint(Move& move) const {
+    int best = -1;
+    for (int from = 0; from < PILE_COUNT; ++from) {
+        for (uint16_t bits = moves_.targets(from); bits; bits &= bits - 1) {
+            const int to = std::countr_zero(bits);
+            const Move candidate = {
+                static_cast<uint8_t>(from), static_cast<uint8_t>(to),
+                static_cast<uint8_t>(moves_.count(from, to))};
+            const int score = Solver::priority(state_, candidate);
+            if (score > best) {
+                best = score;
+                move = candidate;
+            }
+        }
+    }
+    return best >= 0;
+}
+
+bool Game::bestTarget(int from, int count, Move& move) const {
+    int best = -1;
+    for (uint16_t bits = moves_.targets(from); bits; bits &= bits - 1) {
+        const int to = std::countr_zero(bits);
+        if (moves_.count(from, to) != count or to == STOCK) continue;
+        int score = 0;
+        if (isFoundation(to)) {
+            score = 2;
+        } else if (state_.columnSize(to) > 0) {
+            score = 1;
+        }
+        if (score > best) {
+            best = score;
+            move = {static_cast<uint8_t>(from), static_cast<uint8_t>(to),
+                    static_cast<uint8_t>(count)};
+        }
+    }
+    return best >= 0;
+}
+
+}  // namespace klondike
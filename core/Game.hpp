@@ -0,0 +1,66 @@
+#pragma once
+#include <cstdint>
+#include "Klondike.hpp"
+#include "MoveLog.hpp"
+#include "MoveMatrix.hpp"
+#include "Replay.hpp"
+
+namespace klondike {
+
+// A game in progress: the position, the seed it was dealt from and the
+// undo/redo history. Everything that changes the board goes through here,
+// played under the rules of the variant it was dealt with.
+class Game {
+   public:
+    void deal(uint64_t seed, Variant variant = STANDARD) {
+        deal(shuffledDeck(seed), seed, variant);
+    }
+    // `deck` must be shuffledDeck(seed) for recorded replays to play back.
+    void deal(const Deck& deck, uint64_t seed, Variant variant = STANDARD);
+
+    // Picks a saved game back up: `state` with `history` behind it, the
+    // first `applied` moves of which have been played. Nothing is dealt or
+    // recorded; a replay of the deal just carries on.
+    void restore(const State& state, uint64_t seed, Variant variant,
+                 std::span<const PackedMove> history, int applied);
+
+    // Deals, moves, undos and redos from here on are appended to `writer`;
+    // null stops recording.
+    void record(ReplayWriter* writer) { recorder_ = writer; }
+
+    const State& state() const { return state_; }
+    uint64_t seed() const { return seed_; }
+    Variant variant() const { return variant_; }
+    const MoveLog& history() const { return history_; }
+    // Kept up to date through every change below.
+    const MoveMatrix& legalMoves() const { return moves_; }
+
+    // The most promising legal move by Solver::priority; false if there
+    // is nothing worth doing.
+    bool hint(Move& move) const;
+    // Where the top `count` cards of `from` are best sent: home, then onto
+    // another card, then into an empty column. False if nowhere.
+    bool bestTarget(int from, int count, Move& move) const;
+
+    // Applies `move` if it is legal.
+    bool play(Move move);
+
+    // Each returns false when there is nothing to do; otherwise `changed`
+    // is the move whose piles were touched.
+    bool undo(Move& changed);
+    bool redo(Move& changed);
+
+    // Plays back one recorded event. False if it does not fit the position,
+    // which means a damaged replay or a rules change since it was made.
+    bool play(const ReplayEvent& event, Move& changed);
+
+   private:
+    State state_;
+    MoveLog history_;
+    MoveMatrix moves_;
+    uint64_t seed_ = 0;
+    Variant variant_ = STANDARD;
+    ReplayWriter* recorder_ = nullptr;
+};
+
+}  // namespace klondike
@@ -0,0 +1,43 @@
+#pragma once
+#include <cassert>
+
+namespace klondike {
+
+// A vector with its storage inside the object: fixed capacity, never
+// allocates, and trivially copyable whenever T is.
+template <class T, int CAPACITY>
+class InlineVector {
+   public:
+    using value_type = T;
+
+    static constexpr int capacity() { return CAPACITY; }
+    int size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    bool full() const { return size_ == CAPACITY; }
+
+    void push_back(const T& value) {
+        assert(size_ < CAPACITY);
+        items_[size_++] = value;
+    }
+    void pop_back() {
+        assert(size_ > 0);
+        --size_;
+    }
+    void clear() { size_ = 0; }
+
+    T& operator[](int i) { return items_[i]; }
+    const T& operator[](int i) const { return items_[i]; }
+    T& back() { return items_[size_ - 1]; }
+    const T& back() const { return items_[size_ - 1]; }
+
+    T* begin() { return items_; }
+    T* end() { return items_ + size_; }
+    const T* begin() const { return items_; }
+    const T* end() const { return items_ + size_; }
+
+   private:
+    T items_[CAPACITY];
+    int size_ = 0;
+};
+
+}  // namespace klondike
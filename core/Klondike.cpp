@@ -0,0 +1,272 @@
+#include "Klondike.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include "Random.hpp"
+
+namespace klondike {
+
+Deck orderedDeck() {
+    Deck deck;
+    int i = 0;
+    for (int suit = HEARTS; suit <= SPADES; ++suit) {
+        for (int value = 1; value <= RANK_COUNT; ++value) {
+            deck[i++] = Card::make(static_cast<Suit>(suit), value);
+        }
+    }
+    return deck;
+}
+
+Deck shuffledDeck(uint64_t seed) {
+    // std::shuffle's algorithm is up to the standard library, so deals
+    // would differ between toolchains; this loop is the spec.
+    Deck deck = orderedDeck();
+    Random random(seed);
+    for (uint32_t i = DECK_SIZE - 1; i > 0; --i) {
+        std::swap(deck[i], deck[random.below(i + 1)]);
+    }
+    return deck;
+}
+
+State dealFromSeed(uint64_t seed) {
+    State state;
+    state.deal(shuffledDeck(seed));
+    return state;
+}
+
+void State::dealCards(const Deck& deck) {
+    std::memset(this, 0, sizeof(State));
+
+    int next = DECK_SIZE;
+    int end = 0;
+    for (int i = 0; i < TABLEAU_COUNT; ++i) {
+        for (int j = 0; j <= i; ++j) {
+            Card card = deck[--next];
+            cards[end++] = j == i ? card.faceUp() : card.faceDown();
+        }
+        columnEnd[i] = static_cast<uint8_t>(end);
+    }
+    // The stock is stored top first, and the top is the last card taken.
+    for (int i = 0; i < next; ++i) cards[end + i] = deck[i].faceDown();
+    talonSize = static_cast<uint8_t>(next);
+}
+
+int State::pileSize(int pile) const {
+    if (isTableau(pile)) return columnSize(pile);
+    if (pile == STOCK) return stockSize();
+    if (pile == WASTE) return wasteSize;
+    return foundation[pile - FOUNDATION];
+}
+
+Card State::top(int pile) const {
+    assert(pileSize(pile) > 0);
+    if (isTableau(pile)) return cards[columnEnd[pile] - 1];
+    if (pile == STOCK) return cards[talonBegin() + wasteSize];
+    if (pile == WASTE) return cards[talonBegin() + wasteSize - 1];
+    const int suit = pile - FOUNDATION;
+    return Card::make(static_cast<Suit>(suit), foundation[suit], true);
+}
+
+template <class R>
+bool State::isLegal(Move move) const {
+    if (move.from >= PILE_COUNT or move.to >= PILE_COUNT or move.count == 0) {
+        return false;
+    }
+    if (move.from == STOCK) {
+        return move.to == WASTE and stockSize() > 0 and
+               move.count == std::min(R::DRAW_COUNT, stockSize());
+    }
+    if (move.from == WASTE and move.to == STOCK) {
+        if constexpr (R::PASS_LIMIT != UNLIMITED_PASSES) {
+            if (passes + 1 >= R::PASS_LIMIT) return false;
+        }
+        return stockSize() == 0 and move.count == wasteSize;
+    }
+    // Cards never leave a home cell and never go back to the stock.
+    if (isFoundation(move.from) or move.to == STOCK or move.to == WASTE or
+        move.from == move.to) {
+        return false;
+    }
+
+    if (move.count > pileSize(move.from)) return false;
+    if (move.from == WASTE and move.count != 1) return false;
+    const Card moving = cards[segmentEnd(segmentOf(move.from)) - move.count];
+    if (!moving.isFaceUp()) return false;
+
+    if (isFoundation(move.to)) {
+        const int suit = move.to - FOUNDATION;
+        return move.count == 1 and moving.suit() == suit and
+               canFound(moving, foundation[suit]);
+    }
+
+    if (columnSize(move.to) == 0) return canStartColumn(moving);
+    return canStack(moving, top(move.to));
+}
+
+void State::resize(int segment, int delta) {
+    if (segment == WASTE_SEGMENT) {
+        wasteSize = static_cast<uint8_t>(wasteSize + delta);
+        talonSize = static_cast<uint8_t>(talonSize + delta);
+        return;
+    }
+    for (int i = segment; i < TABLEAU_COUNT; ++i) {
+        columnEnd[i] = static_cast<uint8_t>(columnEnd[i] + delta);
+    }
+}
+
+// Moves the top `count` cards of one segment onto another. Everything in
+// between slides over by `count`, which is at most a 52-byte rotate.
+void State::transfer(int from, int to, int count) {
+    Card* fromEnd = cards + segmentEnd(from);
+    Card* toEnd = cards + segmentEnd(to);
+    if (from < to) {
+        std::rotate(fromEnd - count, fromEnd, toEnd);
+    } else {
+        std::rotate(toEnd, fromEnd - count, fromEnd);
+    }
+    resize(from, -count);
+    resize(to, count);
+}
+
+Card State::popTop(int segment) {
+    const int total = talonBegin() + talonSize;
+    const int position = segmentEnd(segment) - 1;
+    const Card card = cards[position];
+    std::memmove(cards + position, cards + position + 1,
+                 static_cast<std::size_t>(total - position - 1));
+    cards[total - 1] = {0};
+    resize(segment, -1);
+    return card;
+}
+
+void State::pushTop(int segment, Card card) {
+    const int total = talonBegin() + talonSize;
+    const int position = segmentEnd(segment);
+    std::memmove(cards + position + 1, cards + position,
+                 static_cast<std::size_t>(total - position));
+    cards[position] = card;
+    resize(segment, 1);
+}
+
+template <class R>
+MoveRecord State::apply(Move move) {
+    assert(isLegal<R>(move));
+    MoveRecord record = {move, false};
+
+    if (move.from == STOCK) {
+        // The stock is stored top first, so drawing several cards leaves
+        // the last one drawn on top of the waste, as dealing them off does.
+        if constexpr (R::DRAW_COUNT == 1) {
+            Card& card = cards[talonBegin() + wasteSize];
+            card = card.faceUp();
+        } else {
+            Card* drawn = cards + talonBegin() + wasteSize;
+            for (int i = 0; i < move.count; ++i) drawn[i] = drawn[i].faceUp();
+        }
+        wasteSize = static_cast<uint8_t>(wasteSize + move.count);
+        return record;
+    }
+    if (move.to == STOCK) {
+        // Turning the waste over makes its bottom card the next one drawn,
+        // and the talon layout already has the cards in that order.
+        Card* waste = cards + talonBegin();
+        for (int i = 0; i < wasteSize; ++i) waste[i] = waste[i].faceDown();
+        wasteSize = 0;
+        if constexpr (R::PASS_LIMIT != UNLIMITED_PASSES) ++passes;
+        addScore<R>(record);
+        return record;
+    }
+
+    const int source = segmentOf(move.from);
+    if (isFoundation(move.to)) {
+        popTop(source);
+        ++foundation[move.to - FOUNDATION];
+    } else {
+        transfer(source, move.to, move.count);
+    }
+
+    if (isTableau(move.from) and columnSize(move.from) > 0) {
+        Card& uncovered = cards[columnEnd[move.from] - 1];
+        if (!uncovered.isFaceUp()) {
+            uncovered = uncovered.faceUp();
+            record.flipped = true;
+        }
+    }
+    addScore<R>(record);
+    return record;
+}
+
+template <class R>
+void State::undo(const MoveRecord& record) {
+    const Move& move = record.move;
+
+    if (move.from == STOCK) {
+        wasteSize = static_cast<uint8_t>(wasteSize - move.count);
+        Card* drawn = cards + talonBegin() + wasteSize;
+        if constexpr (R::DRAW_COUNT == 1) {
+            drawn[0] = drawn[0].faceDown();
+        } else {
+            for (int i = 0; i < move.count; ++i) {
+                drawn[i] = drawn[i].faceDown();
+            }
+        }
+        return;
+    }
+    addScore<R>(record, -1);
+    if (move.to == STOCK) {
+        Card* waste = cards + talonBegin();
+        for (int i = 0; i < move.count; ++i) waste[i] = waste[i].faceUp();
+        wasteSize = move.count;
+        if constexpr (R::PASS_LIMIT != UNLIMITED_PASSES) --passes;
+        return;
+    }
+
+    if (record.flipped) {
+        Card& uncovered = cards[columnEnd[move.from] - 1];
+        uncovered = uncovered.faceDown();
+    }
+
+    const int source = segmentOf(move.from);
+    if (isFoundation(move.to)) {
+        pushTop(source, top(move.to));
+        --foundation[move.to - FOUNDATION];
+    } else {
+        transfer(move.to, source, move.count);
+    }
+}
+
+// The engine is built for these policies; see Rules.hpp.
+#define KLONDIKE_INSTANTIATE_RULES(R)                \
+    template bool State::isLegal<R>(Move) const; \
+    template MoveRecord State::apply<R>(Move);   \
+    template void State::undo<R>(const MoveRecord&);
+KLONDIKE_INSTANTIATE_RULES(SolverRules)
+KLONDIKE_INSTANTIATE_RULES(StandardRules)
+KLONDIKE_INSTANTIATE_RULES(DrawThreeRules)
+KLONDIKE_INSTANTIATE_RULES(VegasRules)
+KLONDIKE_INSTANTIATE_RULES(VegasDrawThreeRules)
+#undef KLONDIKE_INSTANTIATE_RULES
+
+bool State::isWon() const {
+    for (uint8_t top : foundation) {
+        if (top != RANK_COUNT) return false;
+    }
+    return true;
+}
+
+uint64_t State::hash() const {
+    uint64_t words[sizeof(State) / sizeof(uint64_t)];
+    std::memcpy(words, this, sizeof(State));
+    uint64_t hash = 0x9E3779B97F4A7C15ull;
+    for (uint64_t word : words) {
+        hash = (hash ^ word) * 0xBF58476D1CE4E5B9ull;
+        hash ^= hash >> 31;
+    }
+    return hash;
+}
+
+bool State::operator==(const State& other) const {
+    return std::memcmp(this, &other, sizeof(State)) == 0;
+}
+
+}  // namespace klondike
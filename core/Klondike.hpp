@@ -0,0 +1,245 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <type_traits>
+#include "Card.hpp"
+#include "InlineVector.hpp"
+#include "Rules.hpp"
+
+namespace klondike {
+
+// Pile ids shared by moves, undo records and anything that talks about piles.
+enum Pile : uint8_t {
+    TABLEAU = 0,  // 0..6
+    STOCK = 7,
+    WASTE = 8,
+    FOUNDATION = 9,  // 9..12, one per suit in Suit order
+    PILE_COUNT = 13
+};
+
+constexpr int TABLEAU_COUNT = 7;
+constexpr int TALON_SIZE = DECK_SIZE - TABLEAU_COUNT * (TABLEAU_COUNT + 1) / 2;
+
+constexpr bool isTableau(int pile) { return pile >= TABLEAU and pile < STOCK; }
+constexpr bool isFoundation(int pile) {
+    return pile >= FOUNDATION and pile < PILE_COUNT;
+}
+
+// `count` cards from the top of `from` onto `to`. Drawing is STOCK -> WASTE
+// with count 1; recycling the waste is WASTE -> STOCK with the whole waste.
+struct Move {
+    uint8_t from;
+    uint8_t to;
+    uint8_t count;
+
+    constexpr bool operator==(const Move&) const = default;
+};
+
+// No position has more legal moves than this: each column top accepts at
+// most two cards, kings into empty columns, one move home per top card,
+// plus the draw.
+constexpr int MAX_MOVES = 64;
+using MoveList = InlineVector<Move, MAX_MOVES>;
+
+// Everything needed to take a move back.
+struct MoveRecord {
+    Move move;
+    bool flipped;  // the card uncovered in the source column was turned up
+};
+
+// Points a move is worth under the policy R; `flipped` when it turned up a
+// tableau card.
+template <class R>
+constexpr int moveScore(Move move, bool flipped) {
+    if constexpr (R::SCORE == VEGAS_SCORING) {
+        return isFoundation(move.to) ? 5 : 0;
+    } else if constexpr (R::SCORE == STANDARD_SCORING) {
+        if (move.from == WASTE and move.to == STOCK) {
+            return R::DRAW_COUNT == 1 ? -100 : -20;
+        }
+        int points = flipped ? 5 : 0;
+        if (isFoundation(move.to)) {
+            points += 10;
+        } else if (move.from == WASTE and move.to != STOCK) {
+            points += 5;
+        }
+        return points;
+    } else {
+        return 0;
+    }
+}
+
+using Deck = std::array<Card, DECK_SIZE>;
+
+// The 52 cards in suit-major order, face down, as MainDeck builds them.
+Deck orderedDeck();
+// orderedDeck() after a Fisher-Yates shuffle driven by Random(seed). Stable
+// across platforms; see Random.hpp.
+Deck shuffledDeck(uint64_t seed);
+
+// A whole Klondike position in one fixed-size, trivially copyable block, so
+// snapshots are a memcpy and equality/hashing work on raw bytes.
+//
+// The cards still on the table share one array: the seven columns back to
+// back (bottom to top), then the talon. The talon holds the waste bottom to
+// top followed by the stock top to bottom, so drawing only moves the
+// waste/stock boundary. Foundations are always A..n of their suit and only
+// keep n. Unused bytes stay zero.
+struct alignas(8) State {
+    Card cards[DECK_SIZE];
+    uint8_t columnEnd[TABLEAU_COUNT];  // one past the top of each column
+    uint8_t talonSize;
+    uint8_t wasteSize;
+    uint8_t foundation[SUIT_COUNT];  // top value per suit, 0 when empty
+    uint8_t passes;  // waste recycles, only counted when passes are limited
+    // Only kept by scoring policies. Held at the int16_t limits rather
+    // than wrapping, which unlimited recycling at -100 each would reach.
+    int16_t score;
+    uint8_t reserved[4];
+
+    // Deals the way MainDeck/Table/HiddenPool do: cards are taken from the
+    // back of `deck`, column i gets i + 1 cards with the last one face up,
+    // and whatever is left becomes the stock.
+    template <class R = SolverRules>
+    void deal(const Deck& deck) {
+        dealCards(deck);
+        score = R::INITIAL_SCORE;
+    }
+
+    int columnBegin(int column) const {
+        return column == 0 ? 0 : columnEnd[column - 1];
+    }
+    int columnSize(int column) const {
+        return columnEnd[column] - columnBegin(column);
+    }
+    std::span<const Card> column(int column) const {
+        return {cards + columnBegin(column),
+                static_cast<std::size_t>(columnSize(column))};
+    }
+    int talonBegin() const { return columnEnd[TABLEAU_COUNT - 1]; }
+    int stockSize() const { return talonSize - wasteSize; }
+    // Bottom to top.
+    std::span<const Card> waste() const {
+        return {cards + talonBegin(), wasteSize};
+    }
+    // Top to bottom.
+    std::span<const Card> stock() const {
+        return {cards + talonBegin() + wasteSize,
+                static_cast<std::size_t>(stockSize())};
+    }
+
+    // Number of cards in any pile.
+    int pileSize(int pile) const;
+    // Top card of a non-empty pile.
+    Card top(int pile) const;
+
+    // The moves take a rules policy (Rules.hpp). Only drawing, recycling
+    // and the score depend on it.
+    template <class R = SolverRules>
+    bool isLegal(Move move) const;
+    template <class R = SolverRules>
+    MoveRecord apply(Move move);
+    template <class R = SolverRules>
+    void undo(const MoveRecord& record);
+
+    // Appends every legal move to `moves`: a MoveList, or any container
+    // with push_back such as the solver's move stack.
+    template <class R = SolverRules, class Moves>
+    void legalMoves(Moves& moves) const;
+
+    bool isWon() const;
+
+    uint64_t hash() const;
+    bool operator==(const State& other) const;
+
+   private:
+    // Segments of `cards`: the seven columns, then the waste (its top is
+    // the segment end). The stock is only touched by draw/recycle.
+    static constexpr int WASTE_SEGMENT = TABLEAU_COUNT;
+
+    int segmentOf(int pile) const {
+        return pile == WASTE ? WASTE_SEGMENT : pile;
+    }
+    int segmentEnd(int segment) const {
+        return segment == WASTE_SEGMENT ? talonBegin() + wasteSize
+                                        : columnEnd[segment];
+    }
+    void dealCards(const Deck& deck);
+    // Saturating, so undoing a move made at a limit does not give back
+    // exactly the score it started from; nothing relies on that.
+    template <class R>
+    void addScore(const MoveRecord& record, int sign = 1) {
+        if constexpr (R::SCORE != NO_SCORING) {
+            score = static_cast<int16_t>(std::clamp(
+                score + sign * moveScore<R>(record.move, record.flipped),
+                int(INT16_MIN), int(INT16_MAX)));
+        }
+    }
+    void resize(int segment, int delta);
+    void transfer(int from, int to, int count);
+    Card popTop(int segment);
+    void pushTop(int segment, Card card);
+};
+
+static_assert(std::is_trivially_copyable_v<State>);
+static_assert(std::is_trivially_copyable_v<MoveList>);
+
+// The game dealt from `seed`: what MainDeck + Table + HiddenPool produce.
+State dealFromSeed(uint64_t seed);
+static_assert(sizeof(State) == 72);
+
+template <class R, class Moves>
+void State::legalMoves(Moves& moves) const {
+    if (stockSize() > 0) {
+        moves.push_back({STOCK, WASTE,
+                         static_cast<uint8_t>(R::DRAW_COUNT < stockSize()
+                                                  ? R::DRAW_COUNT
+                                                  : stockSize())});
+    } else if (wasteSize > 0 and (R::PASS_LIMIT == UNLIMITED_PASSES or
+                                  passes + 1 < R::PASS_LIMIT)) {
+        moves.push_back({WASTE, STOCK, wasteSize});
+    }
+
+    // Tops are looked up once; every candidate below is then a couple of
+    // byte compares instead of a full isLegal().
+    Card tops[TABLEAU_COUNT];
+    for (int i = 0; i < TABLEAU_COUNT; ++i) {
+        tops[i] = columnSize(i) > 0 ? cards[columnEnd[i] - 1] : Card{0};
+    }
+
+    auto addTargets = [&](uint8_t from, uint8_t count, Card card) {
+        if (count == 1 and canFound(card, foundation[card.suit()])) {
+            moves.push_back(
+                {from, static_cast<uint8_t>(FOUNDATION + int(card.suit())),
+                 1});
+        }
+        for (uint8_t to = TABLEAU; to < TABLEAU + TABLEAU_COUNT; ++to) {
+            if (to == from) continue;
+            const bool fits = tops[to].bits == 0 ? canStartColumn(card)
+                                                 : canStack(card, tops[to]);
+            if (fits) moves.push_back({from, to, count});
+        }
+    };
+
+    if (wasteSize > 0) addTargets(WASTE, 1, top(WASTE));
+    for (uint8_t i = 0; i < TABLEAU_COUNT; ++i) {
+        const auto cards = column(i);
+        for (std::size_t j = cards.size(); j-- > 0 and cards[j].isFaceUp();) {
+            addTargets(static_cast<uint8_t>(TABLEAU + i),
+                       static_cast<uint8_t>(cards.size() - j), cards[j]);
+        }
+    }
+}
+
+}  // namespace klondike
+
+template <>
+struct std::hash<klondike::State> {
+    std::size_t operator()(const klondike::State& state) const {
+        return static_cast<std::size_t>(state.hash());
+    }
+};
@@ -0,0 +1,108 @@
+#include "Layout.hpp"
+#include <algorithm>
+
+namespace klondike {
+
+void Layout::resize(int width, int height) {
+    // Cards keep a 5:7 shape and fit ten across or six down, whichever is
+    // tighter.
+    if (height < width / 13 * 9) {
+        cardSize_ = {float(width / 10), float(width / 10 / 5 * 7)};
+    } else {
+        cardSize_ = {float(height / 6 / 7 * 5), float(height / 6)};
+    }
+    const Point size = cardSize_;
+
+    const Point stock = {float(width) / 8, float(height) / 16};
+    slots_[STOCK] = {stock.x, stock.y, size.x, size.y};
+    slots_[WASTE] = {stock.x + size.x * 5 / 4, stock.y, size.x, size.y};
+
+    columnPitch_ = size.x + size.x / 20;
+    for (int i = 0; i < TABLEAU_COUNT; ++i) {
+        slots_[TABLEAU + i] = {float(width / 8) + float(i) * columnPitch_,
+                               stock.y + size.y + size.y * 5 / 30, size.x,
+                               size.y};
+    }
+
+    foundationPitch_ = size.x + size.x / 10;
+    const Point home = {float(width / 2), float(height / 16)};
+    for (int i = 0; i < SUIT_COUNT; ++i) {
+        slots_[FOUNDATION + i] = {home.x + float(i) * foundationPitch_,
+                                  home.y, size.x, size.y};
+    }
+
+    ++stats_.resizes;
+    markAllDirty();
+}
+
+void Layout::refresh(const State& state, Point positions[CARD_ID_COUNT]) {
+    const uint16_t dirty = dirty_;
+    dirty_ = 0;
+    for (int pile = 0; pile < PILE_COUNT; ++pile) {
+        if (dirty & (1u << pile)) refreshPile(state, pile, positions);
+    }
+}
+
+void Layout::refreshPile(const State& state, int pile, Point positions[]) {
+    ++stats_.pileRefreshes;
+    const Point origin = {slots_[pile].x, slots_[pile].y};
+
+    if (isTableau(pile)) {
+        Point position = origin;
+        for (Card card : state.column(pile)) {
+            positions[card.id()] = position;
+            position.y += FAN_OFFSET;
+        }
+    } else if (pile == STOCK) {
+        for (Card card : state.stock()) positions[card.id()] = origin;
+    } else if (pile == WASTE) {
+        for (Card card : state.waste()) positions[card.id()] = origin;
+    } else {
+        const Suit suit = Suit(pile - FOUNDATION);
+        for (int value = 1; value <= state.foundation[suit]; ++value) {
+            positions[Card::make(suit, value).id()] = origin;
+        }
+    }
+}
+
+int Layout::slotAt(float x, int first, int count, float pitch) const {
+    const float offset = x - slots_[first].x;
+    if (offset < 0) return -1;
+    const int index = int(offset / pitch);
+    if (index >= count) return -1;
+    return offset - float(index) * pitch < cardSize_.x ? index : -1;
+}
+
+Hit Layout::pick(const State& state, Point point) const {
+    const Hit none = {-1, 0};
+    auto inRow = [&](int pile) {
+        return point.y >= slots_[pile].y and
+               point.y < slots_[pile].y + cardSize_.y;
+    };
+
+    // Stock and waste sit side by side above the first columns.
+    for (int pile : {STOCK, WASTE}) {
+        const Rect& slot = slots_[pile];
+        if (inRow(pile) and point.x >= slot.x and
+            point.x < slot.x + slot.width) {
+            return {pile, std::max(state.pileSize(pile) - 1, 0)};
+        }
+    }
+
+    if (inRow(FOUNDATION)) {
+        const int i = slotAt(point.x, FOUNDATION, SUIT_COUNT, foundationPitch_);
+        if (i < 0) return none;
+        return {FOUNDATION + i, std::max(state.foundation[i] - 1, 0)};
+    }
+
+    const int i = slotAt(point.x, TABLEAU, TABLEAU_COUNT, columnPitch_);
+    if (i < 0) return none;
+    const float offset = point.y - slots_[TABLEAU + i].y;
+    const int size = state.columnSize(i);
+    const float fanned = float(std::max(size - 1, 0)) * FAN_OFFSET;
+    if (offset < 0 or offset >= fanned + cardSize_.y) return none;
+    const int top = std::max(size - 1, 0);
+    return {TABLEAU + i, std::min(int(offset / FAN_OFFSET), top)};
+}
+
+}  // namespace klondike
@@ -0,0 +1,83 @@
+#pragma once
+#include <cstdint>
+#include "Klondike.hpp"
+
+namespace klondike {
+
+// Same memory layout as raylib's Vector2/Rectangle, without the dependency.
+struct Point {
+    float x;
+    float y;
+};
+
+struct Rect {
+    float x;
+    float y;
+    float width;
+    float height;
+};
+
+// What is under a point: a pile and the index of the card in it (bottom is
+// 0). Empty piles report index 0; `pile` is -1 when nothing is hit.
+struct Hit {
+    int pile;
+    int index;
+};
+
+// Where everything goes on screen for a given window size. Slot rectangles
+// are recomputed on resize; card positions only for piles marked dirty, so
+// an idle frame does no layout work at all.
+class Layout {
+   public:
+    // Vertical step between fanned cards in a column.
+    static constexpr float FAN_OFFSET = 30;
+
+    struct Stats {
+        uint64_t resizes;
+        uint64_t pileRefreshes;
+    };
+
+    // New window size: recomputes the card size and every slot, and marks
+    // every pile dirty.
+    void resize(int width, int height);
+
+    void markDirty(int pile) { dirty_ |= uint16_t(1u << pile); }
+    void markDirty(Move move) {
+        markDirty(move.from);
+        markDirty(move.to);
+    }
+    void markAllDirty() { dirty_ = ALL_PILES; }
+    bool isDirty() const { return dirty_ != 0; }
+
+    // Writes the resting position of every card in a dirty pile into
+    // `positions` (indexed by Card::id()) and clears the dirty flags.
+    void refresh(const State& state, Point positions[CARD_ID_COUNT]);
+
+    // Constant time whatever the pile sizes: columns and home cells are
+    // found from their x-ranges and the card in a column from the fan
+    // offset, all from the cached slots. Cards being dragged are not
+    // considered; pass the resting state.
+    Hit pick(const State& state, Point point) const;
+
+    Point cardSize() const { return cardSize_; }
+    // Where the bottom card of a pile sits, one card in size.
+    Rect slot(int pile) const { return slots_[pile]; }
+    Stats stats() const { return stats_; }
+
+   private:
+    static constexpr uint16_t ALL_PILES = (1u << PILE_COUNT) - 1;
+
+    void refreshPile(const State& state, int pile, Point positions[]);
+    // Index into a row of equal slots `pitch` apart starting at `first`, or
+    // -1 if `x` is left of it, past `count` or in a gap between slots.
+    int slotAt(float x, int first, int count, float pitch) const;
+
+    Point cardSize_ = {0, 0};
+    Rect slots_[PILE_COUNT] = {};
+    float columnPitch_ = 0;
+    float foundationPitch_ = 0;
+    uint16_t dirty_ = ALL_PILES;
+    Stats stats_ = {};
+};
+
+}  // namespace klondike
@@ -0,0 +1,94 @@
+#include "MappedFile.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace klondike {
+
+#ifdef _WIN32
+
+bool MappedFile::open(const char* path, Access access) {
+    close();
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING,
+                              access == SEQUENTIAL ? FILE_FLAG_SEQUENTIAL_SCAN
+                                                   : FILE_FLAG_RANDOM_ACCESS,
+                              nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        return false;
+    }
+    file_ = file;
+    if (size.QuadPart == 0) return true;
+
+    HANDLE mapping =
+        CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)
+                         : nullptr;
+    if (!view) {
+        if (mapping) CloseHandle(mapping);
+        close();
+        return false;
+    }
+    mapping_ = mapping;
+    data_ = static_cast<const uint8_t*>(view);
+    size_ = std::size_t(size.QuadPart);
+    return true;
+}
+
+void MappedFile::close() {
+    if (data_) UnmapViewOfFile(data_);
+    if (mapping_) CloseHandle(mapping_);
+    if (file_) CloseHandle(file_);
+    data_ = nullptr;
+    size_ = 0;
+    mapping_ = file_ = nullptr;
+}
+
+#else
+
+bool MappedFile::open(const char* path, Access access) {
+    close();
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        ::close(fd);
+        return false;
+    }
+    if (info.st_size > 0) {
+        void* view = mmap(nullptr, std::size_t(info.st_size), PROT_READ,
+                          MAP_PRIVATE, fd, 0);
+        if (view == MAP_FAILED) {
+            ::close(fd);
+            return false;
+        }
+        madvise(view, std::size_t(info.st_size),
+                access == SEQUENTIAL ? MADV_SEQUENTIAL : MADV_RANDOM);
+        data_ = static_cast<const uint8_t*>(view);
+        size_ = std::size_t(info.st_size);
+    }
+    // The mapping keeps the file alive on its own.
+    ::close(fd);
+    return true;
+}
+
+void MappedFile::close() {
+    if (data_) munmap(const_cast<uint8_t*>(data_), size_);
+    data_ = nullptr;
+    size_ = 0;
+}
+
+#endif
+
+}  // namespace klondike
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace klondike {
+
+// A read-only view of a whole file through the OS page cache. Nothing is
+// copied; pages are read in as they are touched and can be dropped again
+// under memory pressure, so arbitrarily large archives can be scanned.
+class MappedFile {
+   public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { close(); }
+
+    // How the bytes will be read, as a hint to the OS read-ahead.
+    enum Access { SEQUENTIAL, RANDOM };
+
+    // An empty file opens fine with no bytes.
+    bool open(const char* path, Access access = SEQUENTIAL);
+    void close();
+
+    std::span<const uint8_t> bytes() const { return {data_, size_}; }
+
+   private:
+    const uint8_t* data_ = nullptr;
+    std::size_t size_ = 0;
+#ifdef _WIN32
+    void* file_ = nullptr;
+    void* mapping_ = nullptr;
+#endif
+};
+
+}  // namespace klondike
@@ -0,0 +1,39 @@
+#include "MoveLog.hpp"
+#include <algorithm>
+#include <cassert>
+
+namespace klondike {
+
+void MoveLog::push(const MoveRecord& record) {
+    size_ = cursor_;
+    if (size_ == CAPACITY) {
+        begin_ = (begin_ + 1) % CAPACITY;
+        --size_;
+        --cursor_;
+    }
+    entries_[(begin_ + size_) % CAPACITY] = PackedMove::pack(record);
+    ++size_;
+    ++cursor_;
+}
+
+void MoveLog::assign(std::span<const PackedMove> entries, int applied) {
+    assert(entries.size() <= std::size_t(CAPACITY) and applied >= 0 and
+           std::size_t(applied) <= entries.size());
+    begin_ = 0;
+    size_ = int(entries.size());
+    cursor_ = applied;
+    std::copy(entries.begin(), entries.end(), entries_);
+}
+
+MoveRecord MoveLog::undo() {
+    assert(canUndo());
+    --cursor_;
+    return (*this)[cursor_];
+}
+
+MoveRecord MoveLog::redo() {
+    assert(canRedo());
+    return (*this)[cursor_++];
+}
+
+}  // namespace klondike
@@ -0,0 +1,70 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include "Klondike.hpp"
+
+namespace klondike {
+
+// A MoveRecord in two bytes: from (4 bits), to (4 bits), count (5 bits,
+// enough for recycling a full waste) and the flip bit.
+struct PackedMove {
+    uint16_t bits;
+
+    static PackedMove pack(const MoveRecord& record) {
+        return {static_cast<uint16_t>(record.move.from |
+                                      record.move.to << 4 |
+                                      record.move.count << 8 |
+                                      (record.flipped ? 1 << 13 : 0))};
+    }
+
+    MoveRecord unpack() const {
+        return {{static_cast<uint8_t>(bits & 0xF),
+                 static_cast<uint8_t>((bits >> 4) & 0xF),
+                 static_cast<uint8_t>((bits >> 8) & 0x1F)},
+                (bits >> 13 & 1) != 0};
+    }
+};
+
+// Undo/redo history as a ring of packed moves. Undo and redo are O(1) and
+// never snapshot the board; recycling the waste is one entry like any other
+// move. The log only hands records back: the caller replays them on the
+// board under whatever rules the game uses. Memory is fixed: past CAPACITY
+// moves the oldest ones can no longer be undone.
+class MoveLog {
+   public:
+    static constexpr int CAPACITY = 4096;
+
+    void clear() { begin_ = size_ = cursor_ = 0; }
+
+    // Records a move just applied; anything that could be redone is gone.
+    void push(const MoveRecord& record);
+
+    bool canUndo() const { return cursor_ > 0; }
+    bool canRedo() const { return cursor_ < size_; }
+
+    // Steps back over the last move and returns it, to be undone.
+    MoveRecord undo();
+    // Steps forward over the last undone move and returns it, to be played
+    // again.
+    MoveRecord redo();
+
+    // Moves that can currently be undone, oldest first.
+    int size() const { return cursor_; }
+    // Moves kept, the redoable ones (from size() on) included.
+    int kept() const { return size_; }
+    // Any of the kept moves, oldest first.
+    MoveRecord operator[](int i) const { return packed(i).unpack(); }
+    PackedMove packed(int i) const { return entries_[(begin_ + i) % CAPACITY]; }
+
+    // Replaces the log with `entries`, oldest first, of which the first
+    // `applied` have been played. For picking a saved game back up.
+    void assign(std::span<const PackedMove> entries, int applied);
+
+   private:
+    PackedMove entries_[CAPACITY];
+    int begin_ = 0;   // oldest entry still kept
+    int size_ = 0;    // entries kept, redoable ones included
+    int cursor_ = 0;  // entries currently applied
+};
+
+}  // namespace klondike
@@ -0,0 +1,94 @@
+#include "MoveMatrix.hpp"
+#include <algorithm>
+
+namespace klondike {
+
+void MoveMatrix::reset(const State& state, const RuleSet& rules) {
+    rules_ = rules;
+    for (int pile = 0; pile < PILE_COUNT; ++pile) refreshPile(state, pile);
+    for (int from = 0; from < PILE_COUNT; ++from) {
+        for (int to = 0; to < PILE_COUNT; ++to) refresh(state, from, to);
+    }
+}
+
+void MoveMatrix::update(const State& state, Move move) {
+    refreshPile(state, move.from);
+    refreshPile(state, move.to);
+    // Every entry depends on its two piles only, so the rows and columns
+    // of the two piles the move touched are all that can have changed.
+    for (int pile : {int(move.from), int(move.to)}) {
+        for (int other = 0; other < PILE_COUNT; ++other) {
+            refresh(state, pile, other);
+            refresh(state, other, pile);
+        }
+    }
+}
+
+bool MoveMatrix::empty() const {
+    for (uint16_t targets : targets_) {
+        if (targets) return false;
+    }
+    return true;
+}
+
+void MoveMatrix::refreshPile(const State& state, int pile) {
+    Pile& info = piles_[pile];
+    if (isFoundation(pile)) {
+        info = {Card{0}, state.foundation[pile - FOUNDATION], 0};
+        return;
+    }
+    const int size = pile == STOCK ? state.stockSize() : state.pileSize(pile);
+    info = {size > 0 ? state.top(pile) : Card{0}, static_cast<uint8_t>(size),
+            0};
+    if (pile == WASTE) {
+        info.run = size > 0;
+    } else if (isTableau(pile)) {
+        const auto cards = state.column(pile);
+        while (info.run < size and cards[size - 1 - info.run].isFaceUp()) {
+            ++info.run;
+        }
+    }
+}
+
+// The same rules as State::isLegal, but working out the count instead of
+// checking a given one.
+void MoveMatrix::refresh(const State& state, int from, int to) {
+    const Pile& source = piles_[from];
+    int count = 0;
+    if (from == STOCK) {
+        count = to == WASTE ? std::min(rules_.drawCount, int(source.size)) : 0;
+    } else if (from == WASTE and to == STOCK) {
+        const bool canRecycle = rules_.passLimit == UNLIMITED_PASSES or
+                                state.passes + 1 < rules_.passLimit;
+        count = piles_[STOCK].size == 0 and canRecycle ? source.size : 0;
+    } else if (source.run > 0 and from != to) {
+        if (isFoundation(to)) {
+            count = source.top.suit() == to - FOUNDATION and
+                    canFound(source.top, piles_[to].size);
+        } else if (isTableau(to)) {
+            // The run holds values top.value() up to top.value() + run - 1,
+            // so the one card that could fit is found by its value.
+            const Pile& target = piles_[to];
+            const int wanted =
+                target.size == 0 ? KING : target.top.value() - 1;
+            const int depth = wanted - source.top.value();
+            if (depth >= 0 and depth < source.run) {
+                const Card card =
+                    from == WASTE
+                        ? source.top
+                        : state.cards[state.columnEnd[from] - 1 - depth];
+                const bool fits = target.size == 0
+                                      ? canStartColumn(card)
+                                      : canStack(card, target.top);
+                count = fits ? depth + 1 : 0;
+            }
+        }
+    }
+
+    counts_[from][to] = static_cast<uint8_t>(count);
+    const auto bit = static_cast<uint16_t>(1u << to);
+    targets_[from] = static_cast<uint16_t>(
+        count ? targets_[from] | bit : targets_[from] & ~bit);
+}
+
+}  // namespace klondike
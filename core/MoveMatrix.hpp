@@ -0,0 +1,63 @@
+#pragma once
+#include <bit>
+#include <cstdint>
+#include "Klondike.hpp"
+
+namespace klondike {
+
+// The legal moves of a position as a from x to table of card counts, kept
+// up to date move by move. A move only changes the piles it touches, so
+// update() recomputes just their rows and columns (about a third of the
+// table) instead of scanning every pile again.
+//
+// Klondike never allows two different counts between the same two piles
+// (only one card of a run can fit a given top), so one count per pair is
+// enough. Finding that card is arithmetic on the run's top value, since
+// face-up runs are always built down by one rank in alternating colours.
+class MoveMatrix {
+   public:
+    // Recomputes everything, for a game played under `rules`.
+    void reset(const State& state,
+               const RuleSet& rules = {1, UNLIMITED_PASSES, NO_SCORING});
+    // Call after `move` was applied to or undone on `state`.
+    void update(const State& state, Move move);
+
+    // Cards the move from `from` to `to` takes, or 0 if there is none.
+    int count(int from, int to) const { return counts_[from][to]; }
+    // Piles that something from `from` can go to, one bit per pile.
+    uint16_t targets(int from) const { return targets_[from]; }
+    bool empty() const;
+
+    // Same moves as State::legalMoves, though not in the same order.
+    template <class Moves>
+    void list(Moves& moves) const;
+
+   private:
+    // What the entries of a pile's row and column are computed from.
+    struct Pile {
+        Card top;     // 0 when empty
+        uint8_t size;  // cards in the pile; for a home cell, its top value
+        uint8_t run;   // face-up cards on top that can move together
+    };
+
+    void refreshPile(const State& state, int pile);
+    void refresh(const State& state, int from, int to);
+
+    RuleSet rules_ = {1, UNLIMITED_PASSES, NO_SCORING};
+    Pile piles_[PILE_COUNT] = {};
+    uint8_t counts_[PILE_COUNT][PILE_COUNT] = {};
+    uint16_t targets_[PILE_COUNT] = {};
+};
+
+template <class Moves>
+void MoveMatrix::list(Moves& moves) const {
+    for (int from = 0; from < PILE_COUNT; ++from) {
+        for (uint16_t bits = targets_[from]; bits; bits &= bits - 1) {
+            const int to = std::countr_zero(bits);
+            moves.push_back({static_cast<uint8_t>(from),
+                             static_cast<uint8_t>(to), counts_[from][to]});
+        }
+    }
+}
+
+}  // namespace klondike
@@ -0,0 +1,115 @@
+#include "Profiler.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+namespace klondike {
+
+namespace {
+
+uint32_t ThreadNumber() {
+    static std::atomic<uint32_t> threads{0};
+    thread_local const uint32_t number = threads.fetch_add(1) + 1;
+    return number;
+}
+
+}  // namespace
+
+Profiler& Profiler::instance() {
+    static Profiler profiler;
+    return profiler;
+}
+
+uint64_t Profiler::nowNs() {
+    return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now().time_since_epoch())
+                        .count());
+}
+
+void Profiler::record(const char* name, uint64_t startNs, uint64_t endNs) {
+    const uint64_t sequence = next_.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = slots_[sequence % CAPACITY];
+    slot.stamp.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.startNs.store(startNs, std::memory_order_relaxed);
+    slot.durationNs.store(uint32_t(std::min<uint64_t>(endNs - startNs,
+                                                      UINT32_MAX)),
+                          std::memory_order_relaxed);
+    slot.thread.store(ThreadNumber(), std::memory_order_relaxed);
+    slot.stamp.store(sequence + 1, std::memory_order_release);
+}
+
+template <class Visit>
+void Profiler::forEachSince(uint64_t sinceNs, Visit&& visit) const {
+    const uint64_t end = next_.load(std::memory_order_acquire);
+    const uint64_t begin = end > CAPACITY ? end - CAPACITY : 0;
+    for (uint64_t sequence = end; sequence-- > begin;) {
+        const Slot& slot = slots_[sequence % CAPACITY];
+        if (slot.stamp.load(std::memory_order_acquire) != sequence + 1) {
+            continue;  // still being written, or already overwritten
+        }
+        Sample sample = {slot.name.load(std::memory_order_relaxed),
+                         slot.startNs.load(std::memory_order_relaxed),
+                         slot.durationNs.load(std::memory_order_relaxed),
+                         slot.thread.load(std::memory_order_relaxed)};
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.stamp.load(std::memory_order_relaxed) != sequence + 1) {
+            continue;
+        }
+        // Other threads may finish out of order, so allow some slack
+        // before deciding everything further back is too old.
+        if (sample.startNs + 1'000'000'000 < sinceNs) break;
+        if (sample.startNs >= sinceNs) visit(sample);
+    }
+}
+
+Profiler::Summary Profiler::summarize(const char* name, uint64_t windowNs) {
+    const uint64_t now = nowNs();
+    int count = 0;
+    forEachSince(now > windowNs ? now - windowNs : 0, [&](const Sample& s) {
+        if (s.name == name) scratch_[count++] = s.durationNs;
+    });
+    if (count == 0) return {0, 0, 0, 0};
+
+    auto percentile = [&](int percent) {
+        uint32_t* nth = scratch_ + (count - 1) * percent / 100;
+        std::nth_element(scratch_, nth, scratch_ + count);
+        return double(*nth) / 1e6;
+    };
+    const double p50 = percentile(50);
+    const double p99 = percentile(99);
+    const double max = double(*std::max_element(scratch_, scratch_ + count));
+    return {count, p50, p99, max / 1e6};
+}
+
+void Profiler::histogram(const char* name, uint64_t windowNs, int buckets[],
+                         int bucketCount, double bucketMs) const {
+    std::fill(buckets, buckets + bucketCount, 0);
+    const uint64_t now = nowNs();
+    forEachSince(now > windowNs ? now - windowNs : 0, [&](const Sample& s) {
+        if (s.name != name) return;
+        const int bucket = int(double(s.durationNs) / 1e6 / bucketMs);
+        ++buckets[std::min(bucket, bucketCount - 1)];
+    });
+}
+
+bool Profiler::writeChromeTrace(const char* path, uint64_t windowNs) const {
+    std::FILE* out = std::fopen(path, "w");
+    if (!out) return false;
+    std::fprintf(out, "{\"traceEvents\": [\n");
+    const uint64_t now = nowNs();
+    bool first = true;
+    forEachSince(now > windowNs ? now - windowNs : 0, [&](const Sample& s) {
+        std::fprintf(out,
+                     "%s{\"name\": \"%s\", \"ph\": \"X\", \"ts\": %.3f, "
+                     "\"dur\": %.3f, \"pid\": 1, \"tid\": %u}",
+                     first ? "" : ",\n", s.name, double(s.startNs) / 1e3,
+                     double(s.durationNs) / 1e3, unsigned(s.thread));
+        first = false;
+    });
+    std::fprintf(out, "\n], \"displayTimeUnit\": \"ms\"}\n");
+    return std::fclose(out) == 0;
+}
+
+}  // namespace klondike
@@ -0,0 +1,83 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+namespace klondike {
+
+// Scoped timings kept in a fixed lock-free ring: any thread may record,
+// nothing allocates, and the newest CAPACITY samples are always there to
+// summarise or export. Names must be string literals (only the pointer is
+// stored).
+class Profiler {
+   public:
+    static constexpr int CAPACITY = 1 << 15;
+
+    struct Sample {
+        const char* name;
+        uint64_t startNs;
+        uint32_t durationNs;
+        uint32_t thread;
+    };
+
+    struct Summary {
+        int count;
+        double p50Ms;
+        double p99Ms;
+        double maxMs;
+    };
+
+    static Profiler& instance();
+    // Monotonic clock shared by every sample.
+    static uint64_t nowNs();
+
+    void record(const char* name, uint64_t startNs, uint64_t endNs);
+
+    // Percentiles of `name` over the samples newer than `windowNs`.
+    Summary summarize(const char* name, uint64_t windowNs);
+    // Counts samples of `name` newer than `windowNs` into `bucketCount`
+    // buckets of `bucketMs`; the last bucket also takes everything slower.
+    void histogram(const char* name, uint64_t windowNs, int buckets[],
+                   int bucketCount, double bucketMs) const;
+
+    // Writes the samples newer than `windowNs` as Chrome trace events
+    // (chrome://tracing, Perfetto).
+    bool writeChromeTrace(const char* path, uint64_t windowNs) const;
+
+   private:
+    // A seqlock per slot: `stamp` is the sample's sequence number plus one
+    // once written, and zero while it is being overwritten.
+    struct Slot {
+        std::atomic<uint64_t> stamp{0};
+        std::atomic<const char*> name{nullptr};
+        std::atomic<uint64_t> startNs{0};
+        std::atomic<uint32_t> durationNs{0};
+        std::atomic<uint32_t> thread{0};
+    };
+
+    // Visits samples newest first until one is older than `sinceNs`.
+    template <class Visit>
+    void forEachSince(uint64_t sinceNs, Visit&& visit) const;
+
+    Slot slots_[CAPACITY];
+    std::atomic<uint64_t> next_{0};
+    uint32_t scratch_[CAPACITY];  // summarize() only, game thread
+};
+
+// Times the enclosing scope.
+class ProfileScope {
+   public:
+    explicit ProfileScope(const char* name)
+        : name_(name), start_(Profiler::nowNs()) {}
+    ~ProfileScope() {
+        Profiler::instance().record(name_, start_, Profiler::nowNs());
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+   private:
+    const char* name_;
+    uint64_t start_;
+};
+
+}  // namespace klondike
@@ -0,0 +1,61 @@
+#pragma once
+#include <cstdint>
+
+namespace klondike {
+
+// Deal generator. The algorithm is part of the save/replay format: the same
+// seed must give the same deal on every platform, compiler and standard
+// library, forever. Changing anything here changes every seeded deal.
+//
+// State is xoshiro256** (Blackman & Vigna, 2018) seeded by running
+// SplitMix64 over the 64-bit seed. Bounded values use Lemire's
+// multiply-and-reject method, so they are unbiased and need no division in
+// the common case.
+class Random {
+   public:
+    explicit Random(uint64_t seed) {
+        for (uint64_t& word : state_) word = splitMix64(seed);
+    }
+
+    uint64_t next() {
+        const uint64_t result = rotl(state_[1] * 5, 7) * 9;
+        const uint64_t t = state_[1] << 17;
+        state_[2] ^= state_[0];
+        state_[3] ^= state_[1];
+        state_[1] ^= state_[2];
+        state_[0] ^= state_[3];
+        state_[2] ^= t;
+        state_[3] = rotl(state_[3], 45);
+        return result;
+    }
+
+    // Uniform in [0, bound), bound > 0.
+    uint32_t below(uint32_t bound) {
+        uint64_t product = uint64_t(uint32_t(next() >> 32)) * bound;
+        uint32_t low = uint32_t(product);
+        if (low < bound) {
+            const uint32_t threshold = uint32_t(-bound) % bound;
+            while (low < threshold) {
+                product = uint64_t(uint32_t(next() >> 32)) * bound;
+                low = uint32_t(product);
+            }
+        }
+        return uint32_t(product >> 32);
+    }
+
+    static uint64_t splitMix64(uint64_t& state) {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+   private:
+    static uint64_t rotl(uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    uint64_t state_[4];
+};
+
+}  // namespace klondike
@@ -0,0 +1,136 @@
+#include "Replay.hpp"
+#include <filesystem>
+
+namespace klondike {
+
+namespace {
+
+constexpr uint8_t MAGIC[3] = {'K', 'D', 'R'};
+
+int PutVarint(uint8_t* out, uint32_t value) {
+    int size = 0;
+    while (value >= 0x80) {
+        out[size++] = static_cast<uint8_t>(value | 0x80);
+        value >>= 7;
+    }
+    out[size++] = static_cast<uint8_t>(value);
+    return size;
+}
+
+}  // namespace
+
+bool ReplayWriter::open(const char* path) {
+    close();
+    file_ = std::fopen(path, "ab");
+    if (!file_) return false;
+    std::fseek(file_, 0, SEEK_END);
+    const long size = std::ftell(file_);
+    size_ = size > 0 ? uint64_t(size) : 0;
+    // The first event after a resume is timed from here.
+    last_ = std::chrono::steady_clock::now();
+    return true;
+}
+
+bool ReplayWriter::resume(const char* path, uint64_t size) {
+    close();
+    std::error_code error;
+    const uintmax_t length = std::filesystem::file_size(path, error);
+    if (error or length < size) return false;
+    std::filesystem::resize_file(path, size, error);
+    return !error and open(path);
+}
+
+void ReplayWriter::close() {
+    if (file_) std::fclose(file_);
+    file_ = nullptr;
+    size_ = 0;
+}
+
+void ReplayWriter::begin(uint64_t seed, Variant variant) {
+    if (!file_) return;
+    uint8_t header[REPLAY_HEADER_SIZE] = {MAGIC[0], MAGIC[1], MAGIC[2],
+                                          REPLAY_VERSION};
+    for (int i = 0; i < 8; ++i) {
+        header[4 + i] = static_cast<uint8_t>(seed >> (8 * i));
+    }
+    header[12] = variant;
+    std::fwrite(header, 1, sizeof header, file_);
+    std::fflush(file_);
+    size_ += sizeof header;
+    last_ = std::chrono::steady_clock::now();
+}
+
+void ReplayWriter::write(unsigned event) {
+    if (!file_) return;
+    auto now = std::chrono::steady_clock::now();
+    auto delay =
+        std::chrono::duration_cast<std::chrono::milliseconds>(now - last_);
+    last_ = now;
+
+    uint8_t buffer[10];
+    int size = PutVarint(buffer, event);
+    size += PutVarint(buffer + size, uint32_t(delay.count()));
+    std::fwrite(buffer, 1, std::size_t(size), file_);
+    std::fflush(file_);
+    size_ += uint64_t(size);
+}
+
+bool ReplayReader::nextGame(uint64_t& seed, Variant& variant) {
+    ReplayEvent skipped;
+    while (next(skipped)) {
+    }
+    if (corrupt_ or pos_ == bytes_.size()) return false;
+
+    if (bytes_.size() - pos_ < REPLAY_HEADER_SIZE or
+        bytes_[pos_] != MAGIC[0] or bytes_[pos_ + 1] != MAGIC[1] or
+        bytes_[pos_ + 2] != MAGIC[2] or bytes_[pos_ + 3] != REPLAY_VERSION or
+        bytes_[pos_ + 12] >= VARIANT_COUNT) {
+        corrupt_ = true;
+        return false;
+    }
+    seed = 0;
+    for (int i = 7; i >= 0; --i) {
+        seed = seed << 8 | bytes_[pos_ + 4 + std::size_t(i)];
+    }
+    variant = Variant(bytes_[pos_ + 12]);
+    pos_ += REPLAY_HEADER_SIZE;
+    return true;
+}
+
+bool ReplayReader::next(ReplayEvent& event) {
+    if (corrupt_ or pos_ == bytes_.size() or bytes_[pos_] == MAGIC[0]) {
+        return false;
+    }
+    uint32_t value;
+    if (!readVarint(value) or !readVarint(event.delayMs)) return false;
+
+    if (value == 0x0E or value == 0x0F) {
+        event.kind = value == 0x0E ? UNDO_EVENT : REDO_EVENT;
+        event.move = {};
+        return true;
+    }
+    event.kind = MOVE_EVENT;
+    event.move = {static_cast<uint8_t>(value & 0xF),
+                  static_cast<uint8_t>((value >> 4) & 0xF),
+                  static_cast<uint8_t>(value >> 8)};
+    if (value >> 8 == 0 or value >> 8 > DECK_SIZE or
+        event.move.from >= PILE_COUNT or event.move.to >= PILE_COUNT) {
+        corrupt_ = true;
+        return false;
+    }
+    return true;
+}
+
+bool ReplayReader::readVarint(uint32_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (pos_ == bytes_.size()) break;
+        uint8_t byte = bytes_[pos_++];
+        value |= uint32_t(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    corrupt_ = true;
+    return false;
+}
+
+}  // namespace klondike
@@ -0,0 +1,85 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <span>
+#include "Klondike.hpp"
+
+namespace klondike {
+
+// Replay files: a 13-byte header ("KDR", version 1, u64 little-endian deal
+// seed, variant) followed by one entry per event until the end of the file
+// or the next header. An entry is two LEB128 varints: the event and the
+// milliseconds since the previous one. A move is from | to << 4 | count << 8
+// (always two bytes); undo and redo are the single bytes 0x0E and 0x0F.
+// No entry starts with 'K', so replay files concatenate into an archive.
+constexpr uint8_t REPLAY_VERSION = 1;
+constexpr int REPLAY_HEADER_SIZE = 13;
+
+enum ReplayEventKind { MOVE_EVENT, UNDO_EVENT, REDO_EVENT };
+
+struct ReplayEvent {
+    ReplayEventKind kind;
+    Move move;  // MOVE_EVENT only
+    uint32_t delayMs;
+};
+
+// Appends one game at a time to a file. Every event is flushed straight
+// away, so a crash still leaves a replay up to the last move.
+class ReplayWriter {
+   public:
+    ReplayWriter() = default;
+    ReplayWriter(const ReplayWriter&) = delete;
+    ReplayWriter& operator=(const ReplayWriter&) = delete;
+    ~ReplayWriter() { close(); }
+
+    bool open(const char* path);
+    // Carries on a game recorded to `path` from a snapshot taken when the
+    // file was `size` bytes long. Events recorded after the snapshot are
+    // cut off, since the game resumes without them. False if the file is
+    // shorter than that.
+    bool resume(const char* path, uint64_t size);
+    void close();
+    bool isOpen() const { return file_ != nullptr; }
+    // Bytes in the file, everything recorded so far included; 0 when not
+    // open.
+    uint64_t size() const { return size_; }
+
+    void begin(uint64_t seed, Variant variant);
+    void move(Move move) { write(move.from | move.to << 4 | move.count << 8); }
+    void undo() { write(0x0E); }
+    void redo() { write(0x0F); }
+
+   private:
+    void write(unsigned event);
+
+    std::FILE* file_ = nullptr;
+    uint64_t size_ = 0;
+    std::chrono::steady_clock::time_point last_;
+};
+
+// Walks the games and events of a replay or archive held in memory,
+// normally a MappedFile. Nothing is copied or allocated.
+class ReplayReader {
+   public:
+    ReplayReader() = default;
+    explicit ReplayReader(std::span<const uint8_t> bytes) : bytes_(bytes) {}
+
+    // Skips what is left of the current game and reads the next header.
+    // False at the end of the data or on something that is not a header.
+    bool nextGame(uint64_t& seed, Variant& variant);
+    // False once the current game has no more events.
+    bool next(ReplayEvent& event);
+
+    // Set when the data stopped making sense; the rest is not read.
+    bool corrupt() const { return corrupt_; }
+
+   private:
+    bool readVarint(uint32_t& value);
+
+    std::span<const uint8_t> bytes_;
+    std::size_t pos_ = 0;
+    bool corrupt_ = false;
+};
+
+}  // namespace klondike
@@ -0,0 +1,82 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+
+namespace klondike {
+
+enum Scoring { NO_SCORING, STANDARD_SCORING, VEGAS_SCORING };
+
+// Passes through the stock, the first one included; 0 means no limit.
+constexpr int UNLIMITED_PASSES = 0;
+
+// A rules policy for State's templated members; moveScore() in Klondike.hpp
+// has the points. Everything is a compile-time constant, so each variant
+// gets its own code with the rule checks folded away, and the default
+// draw-1 path is unchanged.
+template <int DRAW, int PASSES, Scoring SCORING>
+struct Rules {
+    static constexpr int DRAW_COUNT = DRAW;
+    static constexpr int PASS_LIMIT = PASSES;
+    static constexpr Scoring SCORE = SCORING;
+
+    // Vegas starts by paying for the deck.
+    static constexpr int INITIAL_SCORE = SCORE == VEGAS_SCORING ? -52 : 0;
+};
+
+// Moves without score or pass counting: what the solver and the analysis
+// tools use, and the default everywhere.
+using SolverRules = Rules<1, UNLIMITED_PASSES, NO_SCORING>;
+using StandardRules = Rules<1, UNLIMITED_PASSES, STANDARD_SCORING>;
+using DrawThreeRules = Rules<3, UNLIMITED_PASSES, STANDARD_SCORING>;
+using VegasRules = Rules<1, 1, VEGAS_SCORING>;
+using VegasDrawThreeRules = Rules<3, 3, VEGAS_SCORING>;
+
+// The variants a player can pick, for choosing one at run time.
+enum Variant : uint8_t { STANDARD, DRAW_THREE, VEGAS, VEGAS_DRAW_THREE };
+constexpr int VARIANT_COUNT = 4;
+
+// Names for command lines, in Variant order.
+constexpr std::string_view VARIANT_NAMES[VARIANT_COUNT] = {
+    "standard", "draw3", "vegas", "vegas3"};
+
+inline bool parseVariant(std::string_view name, Variant& variant) {
+    for (int i = 0; i < VARIANT_COUNT; ++i) {
+        if (VARIANT_NAMES[i] == name) {
+            variant = Variant(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Calls `visit` with a value of the policy type for `variant`. Branching
+// happens once here; whatever `visit` does runs specialised.
+template <class Visit>
+decltype(auto) withRules(Variant variant, Visit&& visit) {
+    switch (variant) {
+        case DRAW_THREE:
+            return visit(DrawThreeRules{});
+        case VEGAS:
+            return visit(VegasRules{});
+        case VEGAS_DRAW_THREE:
+            return visit(VegasDrawThreeRules{});
+        default:
+            return visit(StandardRules{});
+    }
+}
+
+// The same facts as the policies, as values.
+struct RuleSet {
+    int drawCount;
+    int passLimit;
+    Scoring scoring;
+};
+
+inline RuleSet ruleSet(Variant variant) {
+    return withRules(variant, [](auto rules) {
+        using R = decltype(rules);
+        return RuleSet{R::DRAW_COUNT, R::PASS_LIMIT, R::SCORE};
+    });
+}
+
+}  // namespace klondike
@@ -0,0 +1,327 @@
+#include "Snapshot.hpp"
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace klondike {
+
+namespace {
+
+constexpr uint8_t MAGIC[3] = {'K', 'D', 'S'};
+// Six face-down cards under a full run from king to ace; Zobrist sizes its
+// tables for no more.
+constexpr int MAX_COLUMN_SIZE = TABLEAU_COUNT - 1 + RANK_COUNT;
+constexpr std::size_t STATE_OFFSET = SNAPSHOT_HEADER_SIZE - sizeof(State);
+
+void PutU16(uint8_t* out, unsigned value) {
+    out[0] = static_cast<uint8_t>(value);
+    out[1] = static_cast<uint8_t>(value >> 8);
+}
+
+unsigned GetU16(const uint8_t* in) { return unsigned(in[0] | in[1] << 8); }
+
+uint32_t Fnv1a(const uint8_t* bytes, std::size_t size) {
+    uint32_t hash = 2166136261u;
+    for (std::size_t i = 0; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+// Whether a column is laid out the way play leaves one: at most the
+// face-down cards it was dealt, under a face-up run built down in
+// alternating colours, with a face-up card on top.
+bool IsColumnWellFormed(std::span<const Card> cards, int column) {
+    std::size_t faceDown = 0;
+    while (faceDown < cards.size() and !cards[faceDown].isFaceUp()) {
+        ++faceDown;
+    }
+    if (faceDown > std::size_t(column) or
+        (!cards.empty() and faceDown == cards.size())) {
+        return false;
+    }
+    for (std::size_t i = faceDown + 1; i < cards.size(); ++i) {
+        if (!cards[i].isFaceUp() or !canStack(cards[i], cards[i - 1])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Every card exactly once between the table and the foundations, every
+// pile laid out as play under R can leave it and the unused bytes zero.
+// Enough that no later move can index out of the State or hand the solver
+// a position it was not written for.
+template <class R>
+bool IsWellFormed(const State& state) {
+    int end = 0;
+    for (uint8_t columnEnd : state.columnEnd) {
+        if (columnEnd < end or columnEnd - end > MAX_COLUMN_SIZE) return false;
+        end = columnEnd;
+    }
+    if (state.wasteSize > state.talonSize or state.talonSize > TALON_SIZE) {
+        return false;
+    }
+    if (R::PASS_LIMIT == UNLIMITED_PASSES ? state.passes != 0
+                                          : state.passes >= R::PASS_LIMIT) {
+        return false;
+    }
+    end += state.talonSize;
+
+    bool seen[CARD_ID_COUNT] = {};
+    int home = 0;
+    for (int suit = 0; suit < SUIT_COUNT; ++suit) {
+        if (state.foundation[suit] > RANK_COUNT) return false;
+        home += state.foundation[suit];
+        for (int value = 1; value <= state.foundation[suit]; ++value) {
+            seen[Card::make(Suit(suit), value).id()] = true;
+        }
+    }
+    if (end + home != DECK_SIZE) return false;
+    for (int i = 0; i < end; ++i) {
+        const Card card = state.cards[i];
+        if (card.value() < 1 or card.value() > RANK_COUNT or
+            card.bits & ~(Card::ID_MASK | Card::FACE_UP) or seen[card.id()]) {
+            return false;
+        }
+        seen[card.id()] = true;
+    }
+    // Equality and hashing compare every byte.
+    for (int i = end; i < DECK_SIZE; ++i) {
+        if (state.cards[i].bits != 0) return false;
+    }
+    for (uint8_t reserved : state.reserved) {
+        if (reserved != 0) return false;
+    }
+
+    for (int column = 0; column < TABLEAU_COUNT; ++column) {
+        if (!IsColumnWellFormed(state.column(column), column)) return false;
+    }
+    for (Card card : state.waste()) {
+        if (!card.isFaceUp()) return false;
+    }
+    for (Card card : state.stock()) {
+        if (card.isFaceUp()) return false;
+    }
+    return true;
+}
+
+// Whether `record` could be the move that led to `after`, checked before
+// anything is undone, since State::undo trusts its record.
+template <class R>
+bool CanUndo(const State& after, const MoveRecord& record) {
+    const Move move = record.move;
+    if (move.from >= PILE_COUNT or move.to >= PILE_COUNT or
+        move.count == 0 or move.from == move.to) {
+        return false;
+    }
+    if (move.from == STOCK) {
+        return move.to == WASTE and !record.flipped and
+               move.count <= after.wasteSize;
+    }
+    if (move.to == STOCK) {
+        return move.from == WASTE and !record.flipped and
+               after.wasteSize == 0 and move.count <= after.talonSize;
+    }
+    if (!isTableau(move.from) and move.from != WASTE) return false;
+    if (record.flipped and
+        (!isTableau(move.from) or after.columnSize(move.from) == 0)) {
+        return false;
+    }
+    if (isFoundation(move.to)) {
+        return move.count == 1 and after.foundation[move.to - FOUNDATION] > 0;
+    }
+    return isTableau(move.to) and move.count <= after.columnSize(move.to);
+}
+
+// The undo log has to lead to `state`: the applied moves are taken back
+// one by one, each checked to have been legal, to give exactly the
+// position it is undone from and to leave a well-formed one, and the rest
+// are played forward from `state` the same way. A log that fails could
+// not come from a game, and undoing or redoing it could run off the ends
+// of the piles. Legal moves keep a position well-formed, so the redone
+// ones need no more.
+template <class R>
+bool IsHistoryOf(const State& state, const PackedMove* history, int kept,
+                 int applied) {
+    State before = state;
+    for (int i = applied; i-- > 0;) {
+        if (history[i].bits >> 14 != 0) return false;
+        const MoveRecord record = history[i].unpack();
+        if (!CanUndo<R>(before, record)) return false;
+        const State after = before;
+        before.undo<R>(record);
+        if (!IsWellFormed<R>(before) or !before.isLegal<R>(record.move)) {
+            return false;
+        }
+        State replayed = before;
+        if (replayed.apply<R>(record.move).flipped != record.flipped or
+            !(replayed == after)) {
+            return false;
+        }
+    }
+    State after = state;
+    for (int i = applied; i < kept; ++i) {
+        if (history[i].bits >> 14 != 0) return false;
+        const MoveRecord record = history[i].unpack();
+        if (!after.isLegal<R>(record.move) or
+            after.apply<R>(record.move).flipped != record.flipped) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Gets what was written to `file` onto the disk.
+bool SyncFile(std::FILE* file) {
+    if (std::fflush(file) != 0) return false;
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+// Makes a rename in `directory` survive a crash. Windows has no directory
+// handle to flush; its renames are journalled with the file system.
+bool SyncDirectory(const std::filesystem::path& directory) {
+#ifdef _WIN32
+    (void)directory;
+    return true;
+#else
+    const int fd = ::open(directory.empty() ? "." : directory.c_str(),
+                          O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) return false;
+    const bool synced = fsync(fd) == 0;
+    ::close(fd);
+    return synced;
+#endif
+}
+
+}  // namespace
+
+std::size_t encodeSnapshot(const Game& game, SnapshotBuffer& out,
+                           uint64_t replayBytes) {
+    const MoveLog& history = game.history();
+    uint8_t* bytes = out.data();
+    bytes[0] = MAGIC[0];
+    bytes[1] = MAGIC[1];
+    bytes[2] = MAGIC[2];
+    bytes[3] = SNAPSHOT_VERSION;
+    for (int i = 0; i < 8; ++i) {
+        bytes[4 + i] = static_cast<uint8_t>(game.seed() >> (8 * i));
+    }
+    bytes[12] = game.variant();
+    bytes[13] = 0;
+    PutU16(bytes + 14, unsigned(history.kept()));
+    PutU16(bytes + 16, unsigned(history.size()));
+    for (int i = 0; i < 8; ++i) {
+        bytes[18 + i] = static_cast<uint8_t>(replayBytes >> (8 * i));
+    }
+    std::memcpy(bytes + STATE_OFFSET, &game.state(), sizeof(State));
+    // The only field wider than a byte.
+    PutU16(bytes + STATE_OFFSET + offsetof(State, score),
+           uint16_t(game.state().score));
+
+    std::size_t size = SNAPSHOT_HEADER_SIZE;
+    for (int i = 0; i < history.kept(); ++i, size += 2) {
+        PutU16(bytes + size, history.packed(i).bits);
+    }
+    const uint32_t checksum = Fnv1a(bytes, size);
+    for (int i = 0; i < 4; ++i) {
+        bytes[size++] = static_cast<uint8_t>(checksum >> (8 * i));
+    }
+    return size;
+}
+
+bool decodeSnapshot(std::span<const uint8_t> bytes, Game& game,
+                    uint64_t* replayBytes) {
+    if (bytes.size() < SNAPSHOT_HEADER_SIZE + 4 or bytes[0] != MAGIC[0] or
+        bytes[1] != MAGIC[1] or bytes[2] != MAGIC[2] or
+        bytes[3] != SNAPSHOT_VERSION or bytes[12] >= VARIANT_COUNT) {
+        return false;
+    }
+    const int kept = int(GetU16(&bytes[14]));
+    const int applied = int(GetU16(&bytes[16]));
+    const std::size_t size = SNAPSHOT_HEADER_SIZE + 2 * std::size_t(kept);
+    if (kept > MoveLog::CAPACITY or applied > kept or
+        bytes.size() != size + 4) {
+        return false;
+    }
+    uint32_t checksum = 0;
+    for (int i = 3; i >= 0; --i) checksum = checksum << 8 | bytes[size + i];
+    if (checksum != Fnv1a(bytes.data(), size)) return false;
+
+    State state;
+    std::memcpy(&state, &bytes[STATE_OFFSET], sizeof(State));
+    state.score =
+        int16_t(GetU16(&bytes[STATE_OFFSET + offsetof(State, score)]));
+
+    PackedMove history[MoveLog::CAPACITY];
+    for (int i = 0; i < kept; ++i) {
+        history[i].bits =
+            uint16_t(GetU16(&bytes[SNAPSHOT_HEADER_SIZE + 2 * i]));
+    }
+    // The checksum only catches damage; a file can be forged to pass it.
+    const Variant variant = Variant(bytes[12]);
+    const bool consistent = withRules(variant, [&](auto rules) {
+        using R = decltype(rules);
+        return IsWellFormed<R>(state) and
+               IsHistoryOf<R>(state, history, kept, applied);
+    });
+    if (!consistent) return false;
+
+    uint64_t seed = 0;
+    for (int i = 7; i >= 0; --i) seed = seed << 8 | bytes[4 + i];
+    if (replayBytes) {
+        *replayBytes = 0;
+        for (int i = 7; i >= 0; --i) {
+            *replayBytes = *replayBytes << 8 | bytes[18 + i];
+        }
+    }
+    game.restore(state, seed, variant,
+                 {history, std::size_t(kept)}, applied);
+    return true;
+}
+
+bool saveSnapshot(const Game& game, const char* path, uint64_t replayBytes) {
+    SnapshotBuffer buffer;
+    const std::size_t size = encodeSnapshot(game, buffer, replayBytes);
+
+    const std::string temporary = std::string(path) + ".tmp";
+    std::FILE* file = std::fopen(temporary.c_str(), "wb");
+    if (!file) return false;
+    // On disk before the rename, so a crash leaves the old file or the
+    // whole new one, never a torn one under the real name.
+    const bool written =
+        std::fwrite(buffer.data(), 1, size, file) == size and SyncFile(file);
+    if (std::fclose(file) != 0 or !written) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    std::error_code error;
+    std::filesystem::rename(temporary, path, error);
+    return !error and
+           SyncDirectory(std::filesystem::path(path).parent_path());
+}
+
+bool loadSnapshot(const char* path, Game& game, uint64_t* replayBytes) {
+    std::FILE* file = std::fopen(path, "rb");
+    if (!file) return false;
+    // One byte more than fits, so an oversized file does not decode.
+    uint8_t buffer[SNAPSHOT_MAX_SIZE + 1];
+    const std::size_t size = std::fread(buffer, 1, sizeof buffer, file);
+    std::fclose(file);
+    return decodeSnapshot({buffer, size}, game, replayBytes);
+}
+
+}  // namespace klondike
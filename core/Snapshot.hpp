@@ -0,0 +1,54 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include "Game.hpp"
+
+namespace klondike {
+
+// A game in progress as a small binary blob, for resuming after a restart
+// and for handing games between processes. All little-endian:
+//
+//   0   "KDS", version
+//   4   u64 deal seed
+//   12  variant, one zero byte
+//   14  u16 moves kept in the undo log, u16 of them applied
+//   18  u64 bytes of the game's replay file written so far, 0 if none
+//   26  the State as it is in memory (72 bytes)
+//   98  the undo log, oldest first, one PackedMove (u16) per move
+//   end u32 FNV-1a of everything before it
+//
+// Restoring copies the State and the log straight back; nothing is dealt.
+// The piles are first checked to be laid out as play leaves them, and the
+// log is walked back and forth on a scratch copy of the State, so a
+// crafted file can neither hand the solver an unreachable position nor
+// leave undo or redo with a move that does not fit the board.
+constexpr uint8_t SNAPSHOT_VERSION = 1;
+constexpr std::size_t SNAPSHOT_HEADER_SIZE = 26 + sizeof(State);
+constexpr std::size_t SNAPSHOT_MAX_SIZE =
+    SNAPSHOT_HEADER_SIZE + 2 * MoveLog::CAPACITY + 4;
+
+using SnapshotBuffer = std::array<uint8_t, SNAPSHOT_MAX_SIZE>;
+
+// Writes `game` to the front of `out` and returns the bytes used.
+// `replayBytes` is how long the game's replay file is, so that resuming
+// can cut off whatever was recorded after the snapshot.
+std::size_t encodeSnapshot(const Game& game, SnapshotBuffer& out,
+                           uint64_t replayBytes = 0);
+// False, leaving `game` alone, unless `bytes` is a whole, intact snapshot
+// of a well-formed position with an undo log that leads to it.
+bool decodeSnapshot(std::span<const uint8_t> bytes, Game& game,
+                    uint64_t* replayBytes = nullptr);
+
+// Replaces the file at `path` in one step: the snapshot goes to a
+// temporary file next to it, is synced to disk and then renamed over it,
+// and the rename is synced too, so a crash leaves either the old snapshot
+// or the new one.
+bool saveSnapshot(const Game& game, const char* path,
+                  uint64_t replayBytes = 0);
+// False if there is no file or it does not decode.
+bool loadSnapshot(const char* path, Game& game,
+                  uint64_t* replayBytes = nullptr);
+
+}  // namespace klondike
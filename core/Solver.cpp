@@ -0,0 +1,307 @@
+#include "Solver.hpp"
+#include "Random.hpp"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+
+namespace klondike {
+
+namespace {
+
+uint64_t mix(uint64_t x) {
+    x = (x ^ (x >> 33)) * 0xFF51AFD7ED558CCDull;
+    x = (x ^ (x >> 33)) * 0xC4CEB9FE1A85EC53ull;
+    return x ^ (x >> 33);
+}
+
+// What the search stacks need at full depth, per level and in all.
+constexpr std::size_t LEVEL_BYTES = (MAX_MOVES + 1) * sizeof(Move);
+constexpr std::size_t FIXED_STACK_BYTES =
+    DECK_SIZE * (sizeof(MoveRecord) + sizeof(Move));
+
+std::size_t stackBytes(const SolverLimits& limits) {
+    return (std::size_t(limits.maxDepth) + 1) * LEVEL_BYTES +
+           FIXED_STACK_BYTES;
+}
+
+// `limits` with the depth lowered, if need be, until the stacks and the
+// smallest table fit in the memory budget.
+SolverLimits Fitted(SolverLimits limits) {
+    const std::size_t fixed =
+        FIXED_STACK_BYTES + TranspositionTable::MIN_BYTES + LEVEL_BYTES;
+    assert(limits.memoryBytes >= fixed and limits.maxDepth >= 0);
+    const std::size_t levels =
+        (limits.memoryBytes - std::min(limits.memoryBytes, fixed)) /
+        LEVEL_BYTES;
+    limits.maxDepth = int(std::min(std::size_t(limits.maxDepth), levels));
+    return limits;
+}
+
+}  // namespace
+
+Zobrist::Zobrist() {
+    uint64_t seed = 0x6B6C6F6E4B646B65ull;
+    for (auto& row : tableau_)
+        for (auto& key : row) key = Random::splitMix64(seed);
+    for (auto& row : waste_)
+        for (auto& key : row) key = Random::splitMix64(seed);
+    for (auto& row : stock_)
+        for (auto& key : row) key = Random::splitMix64(seed);
+    for (auto& row : foundation_)
+        for (auto& key : row) key = Random::splitMix64(seed);
+}
+
+const Zobrist& Zobrist::instance() {
+    static const Zobrist zobrist;
+    return zobrist;
+}
+
+uint64_t Zobrist::Parts::canonical() const {
+    uint64_t sum = 0;
+    for (uint64_t column : columns) sum += mix(column);
+    return sum ^ talon ^ foundations;
+}
+
+uint64_t Zobrist::columnHash(const State& state, int column) const {
+    uint64_t hash = 0;
+    int depth = 0;
+    for (Card card : state.column(column)) hash ^= tableau_[card.bits][depth++];
+    return hash;
+}
+
+uint64_t Zobrist::talonHash(const State& state) const {
+    uint64_t hash = 0;
+    auto waste = state.waste();
+    for (std::size_t i = 0; i < waste.size(); ++i) {
+        hash ^= waste_[waste[i].id()][i];
+    }
+    auto stock = state.stock();
+    for (std::size_t i = 0; i < stock.size(); ++i) {
+        hash ^= stock_[stock[i].id()][stock.size() - 1 - i];
+    }
+    return hash;
+}
+
+uint64_t Zobrist::foundationHash(const State& state) const {
+    uint64_t hash = 0;
+    for (int suit = 0; suit < SUIT_COUNT; ++suit) {
+        hash ^= foundation_[suit][state.foundation[suit]];
+    }
+    return hash;
+}
+
+Zobrist::Parts Zobrist::hash(const State& state) const {
+    Parts parts;
+    for (int i = 0; i < TABLEAU_COUNT; ++i) {
+        parts.columns[i] = columnHash(state, i);
+    }
+    parts.talon = talonHash(state);
+    parts.foundations = foundationHash(state);
+    return parts;
+}
+
+void Zobrist::update(Parts& parts, const State& state, Move move) const {
+    for (int pile : {move.from, move.to}) {
+        if (isTableau(pile)) {
+            parts.columns[pile] = columnHash(state, pile);
+        } else if (pile == STOCK or pile == WASTE) {
+            parts.talon = talonHash(state);
+        } else {
+            parts.foundations = foundationHash(state);
+        }
+    }
+}
+
+TranspositionTable::TranspositionTable(std::size_t bytes) {
+    std::size_t capacity = MIN_BYTES / sizeof(std::atomic<uint64_t>);
+    while (capacity * 2 * sizeof(std::atomic<uint64_t>) <= bytes) {
+        capacity *= 2;
+    }
+    slots_ = std::make_unique<std::atomic<uint64_t>[]>(capacity);
+    mask_ = capacity - 1;
+}
+
+bool TranspositionTable::insert(uint64_t key) {
+    const uint64_t tagged = (key & ~GENERATION_MASK) | generation_;
+    std::size_t index = static_cast<std::size_t>(key >> 8) & mask_;
+    for (int probe = 0; probe < PROBES; ++probe) {
+        auto& slot = slots_[(index + probe) & mask_];
+        uint64_t seen = slot.load(std::memory_order_relaxed);
+        while ((seen & GENERATION_MASK) != generation_) {
+            if (slot.compare_exchange_weak(seen, tagged,
+                                           std::memory_order_relaxed)) {
+                used_.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        if (seen == tagged) return false;
+    }
+    return true;
+}
+
+void TranspositionTable::clear() {
+    used_.store(0, std::memory_order_relaxed);
+    if (++generation_ <= GENERATION_MASK) return;
+    generation_ = 1;
+    for (std::size_t i = 0; i <= mask_; ++i) {
+        slots_[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+Solver::Solver(SolverLimits limits)
+    : limits_(Fitted(limits)),
+      table_(limits_.memoryBytes - stackBytes(limits_)) {
+    // Reserve every stack up front: the search itself never allocates, so
+    // the memory cap holds for the whole run.
+    moveStack_.reserve(std::size_t(limits_.maxDepth + 1) * MAX_MOVES);
+    autoMoves_.reserve(DECK_SIZE);
+    path_.reserve(std::size_t(limits_.maxDepth) + 1 + DECK_SIZE);
+}
+
+int Solver::priority(const State& state, Move move) {
+    if (isFoundation(move.to)) return 6;
+    if (move.from == WASTE) return 4;
+    if (move.from == STOCK) return 2;
+    if (move.to == STOCK) return 1;
+
+    const int size = state.columnSize(move.from);
+    if (move.count == size) {
+        // A whole column onto an empty one is just a column swap.
+        return state.columnSize(move.to) == 0 ? -1 : 3;
+    }
+    // Uncovering a face-down card beats shuffling runs around.
+    return state.column(move.from)[size - move.count - 1].isFaceUp() ? 0 : 5;
+}
+
+bool Solver::isSafeToFound(const State& state, Card card) {
+    const int value = card.value();
+    if (!canFound(card, state.foundation[card.suit()])) return false;
+    if (value <= 2) return true;
+    for (int suit = 0; suit < SUIT_COUNT; ++suit) {
+        if (isRed(static_cast<Suit>(suit)) != isRed(card.suit()) and
+            state.foundation[suit] < value - 1) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Solver::outOfBudget() {
+    if (stopped_ or stats_.nodes >= limits_.maxNodes) return stopped_ = true;
+    // The clock and the cancel flag are only looked at every few thousand
+    // nodes; either is still noticed within a millisecond or so.
+    if (stats_.nodes % 4096 != 0) return false;
+    if (limits_.cancel and limits_.cancel->load(std::memory_order_relaxed)) {
+        return stopped_ = true;
+    }
+    if (limits_.maxSeconds > 0 and
+        std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                      begin_)
+                .count() > limits_.maxSeconds) {
+        return stopped_ = true;
+    }
+    return false;
+}
+
+Solution Solver::solve(const State& start) {
+    stats_ = {};
+    gaveUp_ = false;
+    stopped_ = false;
+    table_.clear();
+    moveStack_.clear();
+    autoMoves_.clear();
+    path_.clear();
+
+    begin_ = std::chrono::steady_clock::now();
+    State state = start;
+    const bool won = search(state, Zobrist::instance().hash(state), 0);
+    stats_.seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - begin_)
+                         .count();
+    stats_.positionsStored = table_.size();
+    stats_.memoryBytes = table_.memoryBytes() +
+                         moveStack_.capacity() * sizeof(Move) +
+                         autoMoves_.capacity() * sizeof(MoveRecord) +
+                         path_.capacity() * sizeof(Move);
+
+    Solution solution = {won ? SOLVED : gaveUp_ ? GAVE_UP : UNSOLVABLE, {},
+                         stats_};
+    if (won) solution.moves = path_;
+    return solution;
+}
+
+bool Solver::search(State& state, Zobrist::Parts hash, int depth) {
+    ++stats_.nodes;
+    if (outOfBudget() or depth >= limits_.maxDepth) {
+        gaveUp_ = true;
+        return false;
+    }
+
+    // Safe foundation moves never hurt, so play them without branching.
+    const std::size_t pathMark = path_.size();
+    const std::size_t autoMark = autoMoves_.size();
+    for (bool played = true; played;) {
+        played = false;
+        for (uint8_t pile : {uint8_t(WASTE), uint8_t(0), uint8_t(1), uint8_t(2),
+                             uint8_t(3), uint8_t(4), uint8_t(5), uint8_t(6)}) {
+            if (state.pileSize(pile) == 0) continue;
+            const Card card = state.top(pile);
+            if (!card.isFaceUp() or !isSafeToFound(state, card)) continue;
+            const Move move = {
+                pile, static_cast<uint8_t>(FOUNDATION + int(card.suit())), 1};
+            autoMoves_.push_back(state.apply(move));
+            path_.push_back(move);
+            Zobrist::instance().update(hash, state, move);
+            played = true;
+        }
+    }
+
+    if (state.isWon()) return true;
+
+    bool won = false;
+    if (table_.insert(hash.canonical())) {
+        const std::size_t first = moveStack_.size();
+        state.legalMoves(moveStack_);
+        const std::size_t last = moveStack_.size();
+
+        int priorities[MAX_MOVES];
+        for (std::size_t i = first; i < last; ++i) {
+            // Insertion sort by priority; std::stable_sort would allocate.
+            const Move move = moveStack_[i];
+            const int score = priority(state, move);
+            std::size_t j = i - first;
+            for (; j > 0 and priorities[j - 1] < score; --j) {
+                priorities[j] = priorities[j - 1];
+                moveStack_[first + j] = moveStack_[first + j - 1];
+            }
+            priorities[j] = score;
+            moveStack_[first + j] = move;
+        }
+
+        for (std::size_t i = first; i < last and !won; ++i) {
+            if (priorities[i - first] < 0) break;
+            const Move move = moveStack_[i];
+            const MoveRecord record = state.apply(move);
+            path_.push_back(move);
+            Zobrist::Parts child = hash;
+            Zobrist::instance().update(child, state, move);
+            won = search(state, child, depth + 1);
+            if (!won) {
+                path_.pop_back();
+                state.undo(record);
+            }
+        }
+        moveStack_.resize(first);
+    }
+
+    if (!won) {
+        while (autoMoves_.size() > autoMark) {
+            state.undo(autoMoves_.back());
+            autoMoves_.pop_back();
+        }
+        path_.resize(pathMark);
+    }
+    return won;
+}
+
+}  // namespace klondike
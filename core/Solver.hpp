@@ -0,0 +1,149 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Klondike.hpp"
+
+namespace klondike {
+
+// Zobrist keys for State. Columns are hashed on their own and folded
+// together with a commutative sum, so positions that differ only in which
+// column holds which pile (e.g. a king moved to empty column 2 instead of 5)
+// hash the same.
+class Zobrist {
+   public:
+    struct Parts {
+        uint64_t columns[TABLEAU_COUNT];
+        uint64_t talon;
+        uint64_t foundations;
+
+        uint64_t canonical() const;
+    };
+
+    static const Zobrist& instance();
+
+    Parts hash(const State& state) const;
+    // Recomputes only the parts a move between these piles can change.
+    void update(Parts& parts, const State& state, Move move) const;
+
+   private:
+    Zobrist();
+
+    uint64_t columnHash(const State& state, int column) const;
+    uint64_t talonHash(const State& state) const;
+    uint64_t foundationHash(const State& state) const;
+
+    static constexpr int MAX_COLUMN = TABLEAU_COUNT - 1 + RANK_COUNT;
+
+    uint64_t tableau_[2 * CARD_ID_COUNT][MAX_COLUMN];  // by Card::bits
+    uint64_t waste_[CARD_ID_COUNT][TALON_SIZE];        // from the bottom
+    uint64_t stock_[CARD_ID_COUNT][TALON_SIZE];        // from the bottom
+    uint64_t foundation_[SUIT_COUNT][RANK_COUNT + 1];
+};
+
+// Fixed-size, lock-free set of visited position hashes. Several searches may
+// share one table; inserts race through compare-and-swap only. When a probe
+// window is full the position is simply not remembered.
+//
+// Slots carry an 8-bit generation in their low bits, so starting a new
+// search is O(1) instead of wiping the whole table.
+class TranspositionTable {
+   public:
+    // Slots an insert looks at; a table is never smaller than that.
+    static constexpr int PROBES = 8;
+    static constexpr std::size_t MIN_BYTES =
+        PROBES * sizeof(std::atomic<uint64_t>);
+
+    // The largest power-of-two table that fits in `bytes`.
+    explicit TranspositionTable(std::size_t bytes);
+
+    // True if `key` was not in the table yet.
+    bool insert(uint64_t key);
+    // Forgets every stored position.
+    void clear();
+
+    std::size_t capacity() const { return mask_ + 1; }
+    std::size_t memoryBytes() const {
+        return capacity() * sizeof(std::atomic<uint64_t>);
+    }
+    std::size_t size() const { return used_.load(std::memory_order_relaxed); }
+
+   private:
+    static constexpr uint64_t GENERATION_MASK = 0xFF;
+
+    std::unique_ptr<std::atomic<uint64_t>[]> slots_;
+    std::size_t mask_;
+    uint64_t generation_ = 1;
+    std::atomic<std::size_t> used_{0};
+};
+
+struct SolverLimits {
+    // Hard cap on everything the search allocates, transposition table
+    // included. A budget too small for maxDepth's stacks lowers the depth
+    // instead; it must leave room for at least one level, under 1 KB.
+    std::size_t memoryBytes = std::size_t(64) << 20;
+    uint64_t maxNodes = 20'000'000;
+    int maxDepth = 1000;
+    // Wall-clock limit per solve; 0 for none.
+    double maxSeconds = 0;
+    // Another thread sets this to stop the search early (GAVE_UP).
+    const std::atomic<bool>* cancel = nullptr;
+};
+
+struct SolverStats {
+    uint64_t nodes = 0;
+    double seconds = 0;
+    std::size_t memoryBytes = 0;
+    std::size_t positionsStored = 0;
+
+    double nodesPerSecond() const {
+        return seconds > 0 ? double(nodes) / seconds : 0;
+    }
+};
+
+enum Verdict { SOLVED, UNSOLVABLE, GAVE_UP };
+
+struct Solution {
+    Verdict verdict;
+    std::vector<Move> moves;  // from the start position, including auto-moves
+    SolverStats stats;
+};
+
+// Depth-first search for a winning line. At every node the safe moves to the
+// foundations are played automatically; positions already seen, up to column
+// order, are skipped through the transposition table.
+class Solver {
+   public:
+    explicit Solver(SolverLimits limits = {});
+
+    Solution solve(const State& start);
+    // Only the node budget may change between solves; memory and depth
+    // are sized at construction.
+    void setMaxNodes(uint64_t maxNodes) { limits_.maxNodes = maxNodes; }
+
+    // How promising `move` looks: higher is tried first, and negative
+    // moves (column swaps) are not tried at all.
+    static int priority(const State& state, Move move);
+    // Cards that can go home without ever being needed on the tableau: aces,
+    // twos, and cards whose opposite-colour predecessors are both home.
+    static bool isSafeToFound(const State& state, Card card);
+
+   private:
+    bool search(State& state, Zobrist::Parts hash, int depth);
+    bool outOfBudget();
+
+    SolverLimits limits_;
+    TranspositionTable table_;
+    std::vector<Move> moveStack_;
+    std::vector<MoveRecord> autoMoves_;
+    std::vector<Move> path_;
+    SolverStats stats_;
+    std::chrono::steady_clock::time_point begin_;
+    bool gaveUp_ = false;
+    bool stopped_ = false;  // out of nodes, time or cancelled; sticky
+};
+
+}  // namespace klondike
@@ -0,0 +1,95 @@
+#include "ThreadPool.hpp"
+
+namespace klondike {
+
+namespace {
+thread_local int workerIndex = -1;
+}
+
+ThreadPool::ThreadPool(unsigned threads) {
+    if (threads == 0) threads = 1;
+    for (unsigned i = 0; i < threads; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    for (unsigned i = 0; i < threads; ++i) {
+        workers_[i]->thread = std::thread(&ThreadPool::run, this, int(i));
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock(sleepMutex_);
+        stopping_ = true;
+    }
+    wakeUp_.notify_all();
+    for (auto& worker : workers_) worker->thread.join();
+}
+
+int ThreadPool::currentWorker() { return workerIndex; }
+
+void ThreadPool::submit(std::function<void()> task) {
+    unsigned index = workerIndex >= 0
+                         ? unsigned(workerIndex)
+                         : nextWorker_.fetch_add(1, std::memory_order_relaxed);
+    Worker& worker = *workers_[index % workers_.size()];
+    pending_.fetch_add(1);
+    {
+        std::lock_guard lock(worker.mutex);
+        worker.tasks.push_back(std::move(task));
+    }
+    {
+        // Taking the lock orders this with a worker deciding to sleep.
+        std::lock_guard lock(sleepMutex_);
+        queued_.fetch_add(1);
+    }
+    wakeUp_.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock lock(sleepMutex_);
+    allDone_.wait(lock, [this] { return pending_.load() == 0; });
+}
+
+bool ThreadPool::popOwn(int index, std::function<void()>& task) {
+    Worker& worker = *workers_[index];
+    std::lock_guard lock(worker.mutex);
+    if (worker.tasks.empty()) return false;
+    task = std::move(worker.tasks.back());
+    worker.tasks.pop_back();
+    return true;
+}
+
+bool ThreadPool::steal(int thief, std::function<void()>& task) {
+    const int count = int(workers_.size());
+    for (int offset = 1; offset < count; ++offset) {
+        Worker& victim = *workers_[(thief + offset) % count];
+        std::lock_guard lock(victim.mutex);
+        if (victim.tasks.empty()) continue;
+        task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::run(int index) {
+    workerIndex = index;
+    std::function<void()> task;
+    for (;;) {
+        if (popOwn(index, task) or steal(index, task)) {
+            queued_.fetch_sub(1);
+            task();
+            task = nullptr;
+            if (pending_.fetch_sub(1) == 1) {
+                std::lock_guard lock(sleepMutex_);
+                allDone_.notify_all();
+            }
+            continue;
+        }
+        std::unique_lock lock(sleepMutex_);
+        wakeUp_.wait(lock, [this] { return stopping_ or queued_.load() > 0; });
+        if (stopping_ and queued_.load() == 0) return;
+    }
+}
+
+}  // namespace klondike
@@ -0,0 +1,57 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace klondike {
+
+// Work-stealing pool: every worker owns a deque, runs its own tasks newest
+// first and, when it runs dry, steals the oldest task from another worker.
+// Good for batches where some tasks take a thousand times longer than
+// others (solving deals).
+class ThreadPool {
+   public:
+    explicit ThreadPool(unsigned threads = std::thread::hardware_concurrency());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // From a worker the task goes on that worker's deque; from outside it
+    // is dealt round-robin.
+    void submit(std::function<void()> task);
+    // Blocks until every submitted task has finished.
+    void wait();
+
+    unsigned size() const { return static_cast<unsigned>(workers_.size()); }
+    // Index of the calling worker, or -1 outside the pool.
+    static int currentWorker();
+
+   private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+        std::thread thread;
+    };
+
+    void run(int index);
+    bool popOwn(int index, std::function<void()>& task);
+    bool steal(int thief, std::function<void()>& task);
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<unsigned> nextWorker_{0};
+
+    std::mutex sleepMutex_;
+    std::condition_variable wakeUp_;
+    std::condition_variable allDone_;
+    std::atomic<long> queued_{0};   // submitted, not yet picked up
+    std::atomic<long> pending_{0};  // submitted, not yet finished
+    bool stopping_ = false;
+};
+
+}  // namespace klondike
@@ -0,0 +1,39 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+namespace klondike {
+
+// Latest-value mailbox between one writer and one reader thread. The writer
+// fills back() and publishes it; the reader swaps in the newest published
+// value with update() and reads front(). Neither side ever waits for the
+// other, and a value the reader missed is simply replaced.
+template <class T>
+class TripleBuffer {
+   public:
+    T& back() { return buffers_[back_]; }
+    void publish() {
+        back_ = middle_.exchange(uint8_t(back_ | FRESH),
+                                 std::memory_order_acq_rel) &
+                INDEX;
+    }
+
+    // False if nothing was published since the last update().
+    bool update() {
+        if (!(middle_.load(std::memory_order_relaxed) & FRESH)) return false;
+        front_ = middle_.exchange(front_, std::memory_order_acq_rel) & INDEX;
+        return true;
+    }
+    const T& front() const { return buffers_[front_]; }
+
+   private:
+    static constexpr uint8_t INDEX = 3;
+    static constexpr uint8_t FRESH = 4;
+
+    T buffers_[3] = {};
+    uint8_t back_ = 0;                // writer only
+    std::atomic<uint8_t> middle_{1};  // index, plus FRESH once published
+    uint8_t front_ = 2;               // reader only
+};
+
+}  // namespace klondike
@@ -0,0 +1,170 @@
+#include "Tweens.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace klondike {
+
+namespace {
+
+// Quick off the mark, gentle on landing.
+float EaseOut(float t) {
+    const float rest = 1 - t;
+    return 1 - rest * rest * rest;
+}
+
+bool SamePoint(Point a, Point b) { return a.x == b.x and a.y == b.y; }
+
+// Every card with its current face: the table in order (columns bottom to
+// top, then waste and stock), then the foundations from the ace up.
+template <class Visit>
+void ForEachCard(const State& state, Visit visit) {
+    const int end = state.talonBegin() + state.talonSize;
+    for (int i = 0; i < end; ++i) visit(state.cards[i]);
+    for (int suit = 0; suit < SUIT_COUNT; ++suit) {
+        for (int value = 1; value <= state.foundation[suit]; ++value) {
+            visit(Card::make(Suit(suit), value, true));
+        }
+    }
+}
+
+}  // namespace
+
+void Tweens::snap(const State& state, const Point positions[CARD_ID_COUNT]) {
+    animating_ = 0;
+    pending_ = 0;
+    ForEachCard(state, [&](Card card) {
+        place(card, positions[card.id()]);
+    });
+}
+
+void Tweens::gather(Point origin) {
+    animating_ = 0;
+    pending_ = 0;
+    for (int suit = 0; suit < SUIT_COUNT; ++suit) {
+        for (int value = 1; value <= RANK_COUNT; ++value) {
+            place(Card::make(Suit(suit), value), origin);
+        }
+    }
+}
+
+bool Tweens::follow(const State& state,
+                    const Point positions[CARD_ID_COUNT]) {
+    int moves = 0;
+    bool started = false;
+    ForEachCard(state, [&](Card card) {
+        Tween& tween = tweens_[card.id()];
+        const bool moving = !SamePoint(positions[card.id()], tween.to);
+        const bool flipping = card.isFaceUp() != tween.card.isFaceUp();
+        if (flipping) {
+            tween.card = card;
+            tween.flipped = 0;
+            animating_ |= uint64_t(1) << card.id();
+            started = true;
+        }
+        if (moving) {
+            start(card.id(), positions[card.id()], moves++ * STAGGER_TICKS);
+            started = true;
+        }
+    });
+    return started;
+}
+
+void Tweens::moveTo(Card card, Point to, int delayTicks) {
+    Tween& tween = tweens_[card.id()];
+    if (card.isFaceUp() != tween.card.isFaceUp()) tween.flipped = 0;
+    tween.card = card;
+    start(card.id(), to, delayTicks);
+}
+
+void Tweens::place(Card card, Point at) {
+    tweens_[card.id()] = {card, at, at, 0, MOVE_TICKS, FLIP_TICKS};
+    animating_ &= ~(uint64_t(1) << card.id());
+}
+
+void Tweens::start(int id, Point to, int delayTicks) {
+    Tween& tween = tweens_[id];
+    // From wherever it was last tick, so a card turned around mid-flight
+    // does not jump.
+    tween.from = isAnimating(id) ? positionAt(tween, tween.moved) : tween.to;
+    tween.to = to;
+    tween.wait = int16_t(delayTicks);
+    tween.moved = 0;
+    if (!isAnimating(id)) tween.flipped = FLIP_TICKS;
+    animating_ |= uint64_t(1) << id;
+}
+
+bool Tweens::advance(double seconds) {
+    if (animating_ == 0) {
+        pending_ = 0;
+        return false;
+    }
+    pending_ += std::min(seconds, MAX_STEP_SECONDS);
+    bool finished = false;
+    for (; pending_ >= TICK_SECONDS; pending_ -= TICK_SECONDS) {
+        for (uint64_t bits = animating_; bits; bits &= bits - 1) {
+            const int id = std::countr_zero(bits);
+            Tween& tween = tweens_[id];
+            if (tween.wait > 0) {
+                --tween.wait;
+                continue;
+            }
+            tween.moved = int16_t(std::min(tween.moved + 1, MOVE_TICKS));
+            tween.flipped = int16_t(std::min(tween.flipped + 1, FLIP_TICKS));
+            if (tween.moved == MOVE_TICKS and tween.flipped == FLIP_TICKS) {
+                animating_ &= ~(uint64_t(1) << id);
+                finished = true;
+            }
+        }
+    }
+    return finished;
+}
+
+Tweens::Pose Tweens::pose(int id) const {
+    const Tween& tween = tweens_[id];
+    if (!isAnimating(id)) return {tween.to, 1, false};
+
+    // Drawn between the tick before last and the last one, `alpha` of the
+    // way along, so motion is smooth whatever the frame rate.
+    const float alpha = float(pending_ / TICK_SECONDS);
+    const auto sinceLast = [&](int ticks) {
+        if (tween.wait > 0) return 0.0f;
+        return std::max(float(ticks) - 1 + alpha, 0.0f);
+    };
+    const float flip =
+        std::min(sinceLast(tween.flipped) / float(FLIP_TICKS), 1.0f);
+    // Narrows to nothing halfway, where the face changes, and widens again.
+    return {positionAt(tween, sinceLast(tween.moved)),
+            std::abs(1 - 2 * flip), flip < 0.5f};
+}
+
+Point Tweens::positionAt(const Tween& tween, float tick) const {
+    const float t = EaseOut(std::min(tick / float(MOVE_TICKS), 1.0f));
+    return {tween.from.x + (tween.to.x - tween.from.x) * t,
+            tween.from.y + (tween.to.y - tween.from.y) * t};
+}
+
+int Tweens::drawOrder(Card cards[CARD_ID_COUNT]) const {
+    int count = 0;
+    for (uint64_t bits = animating_; bits; bits &= bits - 1) {
+        cards[count++] = tweens_[std::countr_zero(bits)].card;
+    }
+    // Ascending: the longest wait first, down to the shortest, then the
+    // furthest along down to the one that has only just set off.
+    const auto key = [&](Card card) {
+        const Tween& tween = tweens_[card.id()];
+        return tween.wait > 0 ? -MOVE_TICKS - tween.wait : -tween.moved;
+    };
+    // At most 52 cards; an insertion sort keeps it allocation-free.
+    for (int i = 1; i < count; ++i) {
+        const Card card = cards[i];
+        int j = i;
+        for (; j > 0 and key(cards[j - 1]) > key(card); --j) {
+            cards[j] = cards[j - 1];
+        }
+        cards[j] = card;
+    }
+    return count;
+}
+
+}  // namespace klondike
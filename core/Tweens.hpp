@@ -0,0 +1,83 @@
+#pragma once
+#include <cstdint>
+#include "Klondike.hpp"
+#include "Layout.hpp"
+
+namespace klondike {
+
+// Card motion between resting places: glides from one spot to another and
+// flips from one face to the other. Every card id has its own slot, so
+// there is nothing to allocate and a full 52-card cascade costs the same
+// per tick as a single card.
+//
+// Tweens advance on a fixed tick, however long frames take, and poses are
+// interpolated between the last two ticks for drawing.
+class Tweens {
+   public:
+    static constexpr double TICK_SECONDS = 1.0 / 120;
+    static constexpr int MOVE_TICKS = 24;
+    static constexpr int FLIP_TICKS = 16;
+    // Between cards set off by the same follow(), so they leave in turn.
+    static constexpr int STAGGER_TICKS = 2;
+    // Longer gaps (a stall, a window drag) are not caught up on.
+    static constexpr double MAX_STEP_SECONDS = 0.25;
+
+    // How to draw a card: where, at what fraction of its width (centred),
+    // and whether it still shows the face it had before its flip.
+    struct Pose {
+        Point position;
+        float width;
+        bool previousFace;
+    };
+
+    // Shows every card at rest at `positions`, ending all motion. For a
+    // new window size, or a game that should appear as it is.
+    void snap(const State& state, const Point positions[CARD_ID_COUNT]);
+    // Shows every card face down at `origin`, so the next follow() deals
+    // them out from there.
+    void gather(Point origin);
+
+    // Starts a tween for every card whose resting place in `positions` or
+    // face in `state` differs from where it is headed, in table order and
+    // STAGGER_TICKS apart. True if any started.
+    bool follow(const State& state, const Point positions[CARD_ID_COUNT]);
+    // Sends `card` from where it is shown to `to`, setting off after
+    // `delayTicks`. follow() leaves it alone as long as `to` is its resting
+    // place.
+    void moveTo(Card card, Point to, int delayTicks);
+    // Shows `card` at `at` straight away, ending its motion. For dragging.
+    void place(Card card, Point at);
+
+    // Runs the whole ticks in `seconds` plus what was left over last time.
+    // True if any tween finished.
+    bool advance(double seconds);
+
+    Pose pose(int id) const;
+    bool isAnimating(int id) const { return (animating_ >> id) & 1; }
+    bool isAnimating() const { return animating_ != 0; }
+
+    // The animating cards in the order to draw them: those still waiting
+    // to set off, last to leave first, then those on their way, first to
+    // leave first, so each lands on top of the one before. Returns the
+    // count.
+    int drawOrder(Card cards[CARD_ID_COUNT]) const;
+
+   private:
+    struct Tween {
+        Card card;      // with the face it is turning to
+        Point from;
+        Point to;       // the resting place
+        int16_t wait;   // ticks before setting off
+        int16_t moved;  // ticks since setting off, up to MOVE_TICKS
+        int16_t flipped;  // likewise up to FLIP_TICKS; FLIP_TICKS if none
+    };
+
+    void start(int id, Point to, int delayTicks);
+    Point positionAt(const Tween& tween, float tick) const;
+
+    Tween tweens_[CARD_ID_COUNT] = {};
+    uint64_t animating_ = 0;
+    double pending_ = 0;  // seconds not yet run as ticks
+};
+
+}  // namespace klondike
@@ -16,6 +16,9 @@ workspace "klonkdike"
         location "./src"
         files { "%{prj.location}/**.hpp", "%{prj.location}/**.cpp" }
 
+        includedirs { "core" }
+        links { "klonkdike_core" }
+
         filter { "system:windows" }
             -- links { "user32", "kernel32", "gdi32" }
             warnings "Extra" -- or "High"/"Everything"?
@@ -36,3 +39,127 @@ workspace "klonkdike"
             optimize "Full" -- or "Speed"?
 
         conan_setup()
+
+    -- Rules engine with no window or raylib dependency, for headless tools.
+    project "klonkdike_core"
+        kind "StaticLib"
+        language "C++"
+        cppdialect "C++20"
+
+        targetdir "build/%{cfg.buildcfg}/lib"
+        objdir "build/%{cfg.buildcfg}/obj/%{prj.name}"
+
+        location "./core"
+        files { "%{prj.location}/**.hpp", "%{prj.location}/**.cpp" }
+
+        filter { "system:windows" }
+            warnings "Extra"
+
+        filter { "system:linux" }
+            enablewarnings { "all", "extra", "pedantic", "conversion" }
+
+        filter "configurations:Debug"
+            defines { "DEBUG" }
+            symbols "On"
+
+        filter "configurations:Release"
+            defines { "NDEBUG" }
+            optimize "Full"
+
+    -- The C batch API (core/BatchApi.h) as a shared library for FFI use.
+    -- Built from the core sources with everything but the kd_* functions
+    -- hidden; Allocations.cpp stays out so it never replaces the host's
+    -- operator new.
+    project "klonkdike_batch"
+        kind "SharedLib"
+        language "C++"
+        cppdialect "C++20"
+
+        targetdir "build/%{cfg.buildcfg}/lib"
+        objdir "build/%{cfg.buildcfg}/obj/%{prj.name}"
+
+        location "./core"
+        files { "%{prj.location}/**.hpp", "%{prj.location}/**.h",
+                "%{prj.location}/**.cpp" }
+        removefiles { "%{prj.location}/Allocations.cpp" }
+
+        defines { "KD_BUILD_SHARED" }
+        pic "On"
+        visibility "Hidden"
+
+        filter { "system:windows" }
+            warnings "Extra"
+
+        filter { "system:linux" }
+            links { "pthread" }
+            enablewarnings { "all", "extra", "pedantic", "conversion" }
+
+        filter "configurations:Debug"
+            defines { "DEBUG" }
+            symbols "On"
+
+        filter "configurations:Release"
+            defines { "NDEBUG" }
+            optimize "Full"
+
+    -- Headless command-line tools (batch analysis and friends).
+    project "klonkdike_cli"
+        kind "ConsoleApp"
+        language "C++"
+        cppdialect "C++20"
+
+        targetdir "build/%{cfg.buildcfg}/bin"
+        objdir "build/%{cfg.buildcfg}/obj/%{prj.name}"
+
+        location "./tools"
+        files { "%{prj.location}/**.hpp", "%{prj.location}/**.cpp" }
+
+        includedirs { "core" }
+        links { "klonkdike_core" }
+
+        filter { "system:windows" }
+            warnings "Extra"
+
+        filter { "system:linux" }
+            links { "pthread" }
+            enablewarnings { "all", "extra", "pedantic", "conversion" }
+
+        filter "configurations:Debug"
+            defines { "DEBUG" }
+            filter { "system:linux" }
+                linkoptions { "-fsanitize=leak,address,undefined" }
+            symbols "On"
+
+        filter "configurations:Release"
+            defines { "NDEBUG" }
+            optimize "Full"
+
+    -- Micro-benchmarks for the headless core.
+    project "klonkdike_bench"
+        kind "ConsoleApp"
+        language "C++"
+        cppdialect "C++20"
+
+        targetdir "build/%{cfg.buildcfg}/bin"
+        objdir "build/%{cfg.buildcfg}/obj/%{prj.name}"
+
+        location "./bench"
+        files { "%{prj.location}/**.hpp", "%{prj.location}/**.cpp" }
+
+        includedirs { "core" }
+        links { "klonkdike_core" }
+
+        filter { "system:windows" }
+            warnings "Extra"
+
+        filter { "system:linux" }
+            links { "pthread" }
+            enablewarnings { "all", "extra", "pedantic", "conversion" }
+
+        filter "configurations:Debug"
+            defines { "DEBUG" }
+            symbols "On"
+
+        filter "configurations:Release"
+            defines { "NDEBUG" }
+            optimize "Full"
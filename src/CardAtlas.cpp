@@ -0,0 +1,33 @@
+#include "CardAtlas.hpp"
+#include <algorithm>
+
+namespace {
+
+// Copies the whole of `image` into `cell`.
+void Blit(Image& atlas, const Image& image, Rectangle cell) {
+    ImageDraw(&atlas, image,
+              {0, 0, float(image.width), float(image.height)}, cell, WHITE);
+}
+
+}  // namespace
+
+void CardAtlas::load(const Image& faces, const Image& back, const Image& slot,
+                     const Image& emptyColumn, const std::string& spillPath) {
+    Image atlas = GenImageColor(int(SIZE.x), int(SIZE.y), BLANK);
+    Blit(atlas, faces,
+         {0, 0, klondike::RANK_COUNT * CELL_WIDTH,
+          klondike::SUIT_COUNT * CELL_HEIGHT});
+    Blit(atlas, back, CardAtlas::back());
+    Blit(atlas, slot, CardAtlas::slot());
+    Blit(atlas, emptyColumn, CardAtlas::emptyColumn());
+    ImageDrawRectangleRec(&atlas, cell(3, 4), WHITE);
+
+    pixels_.load(atlas, spillPath);
+}
+
+void CardAtlas::fit(float cardWidth, float cardHeight) {
+    // Whole cells, so every cell lands on the same pixel grid.
+    const int width = std::max(1, int(cardWidth + 0.5f));
+    const int height = std::max(1, int(cardHeight + 0.5f));
+    pixels_.request(COLUMNS * width, ROWS * height);
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <string>
+#include "raylib.h"
+#include "Card.hpp"
+#include "ScaledTexture.hpp"
+
+// Card faces, the card back, the home-cell slot and the empty-column art
+// packed into one texture at startup, so a whole table is one batch.
+//
+// Cells are 225x315. Rows 0-3 are the spritesheet (value across, suit
+// down); row 4 holds the back, the slot, the empty column and a solid white
+// cell for tinted fills.
+//
+// The texture is rebuilt with cells the size cards are shown at (see
+// fit()); rectangles stay in full-size pixels either way, so draw with
+// SpriteBatch::begin(texture(), SIZE).
+class CardAtlas {
+   public:
+    static constexpr float CELL_WIDTH = 225;
+    static constexpr float CELL_HEIGHT = 315;
+    static constexpr int COLUMNS = klondike::RANK_COUNT;
+    static constexpr int ROWS = 5;
+    static constexpr Vector2 SIZE = {COLUMNS * CELL_WIDTH, ROWS * CELL_HEIGHT};
+
+    // Copies the images into the atlas; unloading them is up to the caller.
+    // The full-size atlas is parked in `spillPath` for rebuilds.
+    void load(const Image& faces, const Image& back, const Image& slot,
+              const Image& emptyColumn, const std::string& spillPath);
+    // Asks for cells of `cardWidth` x `cardHeight`, built in the
+    // background.
+    void fit(float cardWidth, float cardHeight);
+    // True once a rebuild has been swapped in.
+    bool poll() { return pixels_.poll(); }
+    void unload() { pixels_.unload(); }
+
+    const Texture2D& texture() const { return pixels_.texture(); }
+    std::size_t bytes() const { return pixels_.bytes(); }
+    int rebuilds() const { return pixels_.rebuilds(); }
+
+    static Rectangle face(klondike::Card card) {
+        // Face cell of every card id, built at compile time; ids that are
+        // not cards are left empty.
+        static constexpr auto FACES = [] {
+            std::array<Rectangle, klondike::CARD_ID_COUNT> faces = {};
+            for (int suit = 0; suit < klondike::SUIT_COUNT; ++suit) {
+                for (int value = 1; value <= klondike::KING; ++value) {
+                    faces[(suit << 4) | value] = {
+                        float(value - 1) * CELL_WIDTH,
+                        float(suit) * CELL_HEIGHT, CELL_WIDTH, CELL_HEIGHT};
+                }
+            }
+            return faces;
+        }();
+        return FACES[card.id()];
+    }
+    static Rectangle back() { return cell(0, 4); }
+    static Rectangle slot() { return cell(1, 4); }
+    static Rectangle emptyColumn() { return cell(2, 4); }
+    // Inset so bilinear filtering never samples a neighbouring cell.
+    static Rectangle white() {
+        Rectangle white = cell(3, 4);
+        return {white.x + 4, white.y + 4, white.width - 8, white.height - 8};
+    }
+
+   private:
+    static Rectangle cell(int column, int row) {
+        return {float(column) * CELL_WIDTH, float(row) * CELL_HEIGHT,
+                CELL_WIDTH, CELL_HEIGHT};
+    }
+
+    ScaledTexture pixels_;
+};
@@ -0,0 +1,164 @@
+#include "ImageLoader.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+
+namespace {
+
+// Cache files: this header, then width * height RGBA pixels.
+struct CacheHeader {
+    char magic[4];
+    uint32_t width;
+    uint32_t height;
+    uint32_t reserved;
+    uint64_t sourceSize;
+    int64_t sourceTime;
+};
+
+constexpr char CACHE_MAGIC[4] = {'K', 'D', 'I', '1'};
+
+// What a cache entry is checked against: cheap to get, and it changes
+// whenever the file is replaced or edited.
+bool SourceStamp(const std::string& path, uint64_t& size, int64_t& time) {
+    std::error_code error;
+    size = std::filesystem::file_size(path, error);
+    if (error) return false;
+    time = int64_t(std::filesystem::last_write_time(path, error)
+                       .time_since_epoch()
+                       .count());
+    return !error;
+}
+
+bool ReadCache(const std::string& cachePath, uint64_t size, int64_t time,
+               Image& image) {
+    std::FILE* in = std::fopen(cachePath.c_str(), "rb");
+    if (!in) return false;
+    CacheHeader header;
+    bool ok = std::fread(&header, sizeof header, 1, in) == 1 and
+              std::memcmp(header.magic, CACHE_MAGIC, 4) == 0 and
+              header.sourceSize == size and header.sourceTime == time and
+              header.width > 0 and header.height > 0;
+    if (ok) {
+        const std::size_t bytes = std::size_t(header.width) * header.height * 4;
+        void* pixels = MemAlloc(static_cast<unsigned int>(bytes));
+        ok = pixels and std::fread(pixels, 1, bytes, in) == bytes;
+        if (ok) {
+            image = {pixels, int(header.width), int(header.height), 1,
+                     PIXELFORMAT_UNCOMPRESSED_R8G8B8A8};
+        } else {
+            MemFree(pixels);
+        }
+    }
+    std::fclose(in);
+    return ok;
+}
+
+// Written under a temporary name and renamed, so a crash never leaves a
+// half-written cache that would pass the header check.
+bool WriteCache(const std::string& cachePath, uint64_t size, int64_t time,
+                const Image& image) {
+    const std::string temporary = cachePath + ".tmp";
+    std::FILE* out = std::fopen(temporary.c_str(), "wb");
+    if (!out) return false;
+    CacheHeader header = {{}, uint32_t(image.width), uint32_t(image.height),
+                          0, size, time};
+    std::memcpy(header.magic, CACHE_MAGIC, 4);
+    const std::size_t bytes = std::size_t(image.width) * image.height * 4;
+    bool ok = std::fwrite(&header, sizeof header, 1, out) == 1 and
+              std::fwrite(image.data, 1, bytes, out) == bytes;
+    ok = std::fclose(out) == 0 and ok;
+    std::error_code error;
+    if (ok) std::filesystem::rename(temporary, cachePath, error);
+    if (!ok or error) {
+        std::filesystem::remove(temporary, error);
+        return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+ImageLoader::ImageLoader(std::string cacheDir)
+    : cacheDir_(std::move(cacheDir)),
+      pool_(std::min(4u, std::max(1u, std::thread::hardware_concurrency()))) {
+    std::error_code error;
+    std::filesystem::create_directories(cacheDir_, error);
+}
+
+int ImageLoader::add(const char* path, int placeholderWidth,
+                     int placeholderHeight) {
+    assert(count_ < MAX_IMAGES);
+    Entry& entry = entries_[count_];
+    entry = {path, placeholderWidth, placeholderHeight, {}, DECODED};
+    pool_.submit([this, &entry] { load(entry); });
+    return count_++;
+}
+
+void ImageLoader::wait() {
+    pool_.wait();
+    stats_ = {};
+    for (int i = 0; i < count_; ++i) {
+        switch (entries_[i].source) {
+            case FROM_CACHE:
+                ++stats_.fromCache;
+                break;
+            case DECODED:
+                ++stats_.decoded;
+                break;
+            case PLACEHOLDER:
+                ++stats_.placeholders;
+                break;
+        }
+    }
+}
+
+Image ImageLoader::take(int handle) {
+    assert(handle >= 0 and handle < count_);
+    Image image = entries_[handle].image;
+    entries_[handle].image = {};
+    return image;
+}
+
+// Made at runtime, so there is no source to stamp them with.
+bool ImageLoader::writeRaw(const std::string& path, const Image& image) {
+    return WriteCache(path, 0, 0, image);
+}
+
+bool ImageLoader::readRaw(const std::string& path, Image& image) {
+    return ReadCache(path, 0, 0, image);
+}
+
+std::string ImageLoader::cachePath(const std::string& path) const {
+    return cacheDir_ + "/" + std::filesystem::path(path).filename().string() +
+           ".rgba";
+}
+
+// Runs on a pool thread; touches nothing but `entry`.
+void ImageLoader::load(Entry& entry) const {
+    uint64_t size;
+    int64_t time;
+    const bool exists = SourceStamp(entry.path, size, time);
+    const std::string cache = cachePath(entry.path);
+
+    if (exists and ReadCache(cache, size, time, entry.image)) {
+        entry.source = FROM_CACHE;
+        return;
+    }
+
+    entry.image = exists ? LoadImage(entry.path.c_str()) : Image{};
+    if (!entry.image.data) {
+        TraceLog(LOG_WARNING, "ASSETS: %s is missing, using a placeholder",
+                 entry.path.c_str());
+        entry.image = GenImageChecked(entry.placeholderWidth,
+                                      entry.placeholderHeight, 32, 32,
+                                      MAGENTA, BLACK);
+        entry.source = PLACEHOLDER;
+        return;
+    }
+    ImageFormat(&entry.image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+    WriteCache(cache, size, time, entry.image);
+    entry.source = DECODED;
+}
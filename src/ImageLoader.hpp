@@ -0,0 +1,63 @@
+#pragma once
+#include <string>
+#include "raylib.h"
+#include "ThreadPool.hpp"
+
+// Decodes images on worker threads. Every decoded file is also written to
+// `cacheDir` as raw RGBA with the source's size and modification time, and
+// later runs read that back instead of decoding while the source is
+// unchanged. A file that cannot be loaded becomes a checkerboard
+// placeholder of the given size, with a warning, so nothing is silently
+// blank.
+//
+// Images are handed over with take(); upload them and UnloadImage them
+// right away so the CPU copies do not outlive startup. What has to be
+// rescaled later goes back to disk with writeRaw() (see ScaledTexture).
+class ImageLoader {
+   public:
+    struct Stats {
+        int fromCache;
+        int decoded;
+        int placeholders;
+    };
+
+    static constexpr int MAX_IMAGES = 16;
+
+    explicit ImageLoader(std::string cacheDir = "asset_cache");
+
+    // Starts loading `path`; the returned handle is for take().
+    int add(const char* path, int placeholderWidth, int placeholderHeight);
+    // Waits for everything added so far.
+    void wait();
+    // The image for `handle`, in R8G8B8A8, now owned by the caller.
+    Image take(int handle);
+
+    Stats stats() const { return stats_; }
+    const std::string& cacheDir() const { return cacheDir_; }
+
+    // The cache format for images made at runtime, such as the card atlas,
+    // so they can be read back later instead of held in memory. Safe from
+    // any thread.
+    static bool writeRaw(const std::string& path, const Image& image);
+    static bool readRaw(const std::string& path, Image& image);
+
+   private:
+    enum Source { FROM_CACHE, DECODED, PLACEHOLDER };
+
+    struct Entry {
+        std::string path;
+        int placeholderWidth;
+        int placeholderHeight;
+        Image image;
+        Source source;
+    };
+
+    void load(Entry& entry) const;
+    std::string cachePath(const std::string& path) const;
+
+    std::string cacheDir_;
+    klondike::ThreadPool pool_;
+    Entry entries_[MAX_IMAGES];
+    int count_ = 0;
+    Stats stats_ = {};
+};
@@ -0,0 +1,65 @@
+#include "Input.hpp"
+
+void InputQueue::sample(uint64_t nowNs) {
+    const Vector2 mouse = GetMousePosition();
+    if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT)) {
+        push({PRESS, nowNs, mouse, 0, false, false});
+    } else if (IsMouseButtonDown(MOUSE_BUTTON_LEFT) and
+               (mouse.x != mouse_.x or mouse.y != mouse_.y)) {
+        push({DRAG, nowNs, mouse, 0, false, false});
+    }
+    if (IsMouseButtonReleased(MOUSE_BUTTON_LEFT)) {
+        push({RELEASE, nowNs, mouse, 0, false, false});
+    }
+    mouse_ = mouse;
+
+    // raylib queues key presses, so none are lost between polls.
+    const bool control =
+        IsKeyDown(KEY_LEFT_CONTROL) or IsKeyDown(KEY_RIGHT_CONTROL);
+    const bool shift = IsKeyDown(KEY_LEFT_SHIFT) or IsKeyDown(KEY_RIGHT_SHIFT);
+    for (int key; (key = GetKeyPressed()) != 0;) {
+        push({KEY, nowNs, mouse, key, control, shift});
+    }
+}
+
+bool InputQueue::pop(InputEvent& event, uint64_t untilNs) {
+    if (size_ == 0 or events_[head_].timeNs > untilNs) return false;
+    event = events_[head_];
+    head_ = (head_ + 1) % CAPACITY;
+    --size_;
+    return true;
+}
+
+void InputQueue::push(const InputEvent& event) {
+    if (size_ == CAPACITY) {
+        // Only a stalled simulation gets here. Drags go first: a new one
+        // is dropped, and the oldest makes room for anything else.
+        int i = 0;
+        while (i < size_ and events_[(head_ + i) % CAPACITY].kind != DRAG) ++i;
+        if (i == size_ or event.kind == DRAG) return;
+        for (; i > 0; --i) {
+            events_[(head_ + i) % CAPACITY] =
+                events_[(head_ + i - 1) % CAPACITY];
+        }
+        head_ = (head_ + 1) % CAPACITY;
+        --size_;
+    }
+    events_[(head_ + size_) % CAPACITY] = event;
+    ++size_;
+}
+
+void LatencyHistogram::record(uint64_t ns) {
+    const uint64_t ms = ns / 1'000'000;
+    ++buckets_[ms < BUCKETS ? ms : BUCKETS - 1];
+    ++count_;
+}
+
+int LatencyHistogram::percentileMs(int percent) const {
+    const uint64_t target = (count_ * uint64_t(percent) + 99) / 100;
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKETS; ++i) {
+        seen += buckets_[i];
+        if (seen >= target and seen > 0) return i;
+    }
+    return BUCKETS - 1;
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <cstdint>
+#include "raylib.h"
+
+enum InputKind { PRESS, DRAG, RELEASE, KEY };
+
+// One thing the player did, stamped with the time of the poll that saw it
+// (Profiler::nowNs()).
+struct InputEvent {
+    InputKind kind;
+    uint64_t timeNs;
+    Vector2 position;  // the mouse, for PRESS, DRAG and RELEASE
+    int key;           // KEY only
+    bool control;      // held with the key
+    bool shift;
+};
+
+// Turns raylib's polled input state into a queue of events, so the
+// simulation can take them at its own pace rather than the render's. Drags
+// are coalesced to one event per poll, and are what a full queue drops
+// first.
+class InputQueue {
+   public:
+    // Call after every poll, rendered frame or not.
+    void sample(uint64_t nowNs);
+
+    // The oldest event, if it happened by `untilNs`.
+    bool pop(InputEvent& event, uint64_t untilNs);
+    bool empty() const { return size_ == 0; }
+
+   private:
+    static constexpr int CAPACITY = 64;
+
+    void push(const InputEvent& event);
+
+    InputEvent events_[CAPACITY];
+    int head_ = 0;
+    int size_ = 0;
+    Vector2 mouse_ = {0, 0};
+};
+
+// Times from input to the end of the frame that shows its result, in
+// 1 ms buckets for the whole session.
+class LatencyHistogram {
+   public:
+    static constexpr int BUCKETS = 100;  // the last one is 99 ms and up
+
+    void record(uint64_t ns);
+
+    uint64_t count() const { return count_; }
+    // The bucket `percent` of the samples fall in or under, in ms.
+    int percentileMs(int percent) const;
+    const uint64_t* buckets() const { return buckets_; }
+
+   private:
+    uint64_t buckets_[BUCKETS] = {};
+    uint64_t count_ = 0;
+};
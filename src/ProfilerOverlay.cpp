@@ -0,0 +1,74 @@
+#include "ProfilerOverlay.hpp"
+#include "raylib.h"
+#include "Profiler.hpp"
+
+namespace {
+
+constexpr uint64_t WINDOW_NS = 2'000'000'000;
+// Inputs are far sparser than frames.
+constexpr uint64_t LATENCY_WINDOW_NS = 30'000'000'000;
+constexpr int BUCKETS = 34;  // 1 ms each; the last one is 33 ms and up
+constexpr int WIDTH = 300;
+constexpr int LINE = 12;
+
+const char* const phases[] = {
+    PHASE_FRAME,           PHASE_INPUT,        PHASE_LAYOUT,
+    PHASE_DRAW_TABLE,      PHASE_DRAW_HIDDEN_POOL,
+    PHASE_DRAW_STATIC,     PHASE_DRAW_MOVING,  PHASE_DRAW_DRAGGED,
+    PHASE_FLUSH,           PHASE_END_DRAWING,  PHASE_INPUT_LATENCY,
+};
+constexpr int PHASE_COUNT = sizeof phases / sizeof phases[0];
+constexpr int HISTOGRAM_HEIGHT = 60;
+
+// Bars of `phase` over `windowNs` in 1 ms buckets, `label` above them.
+void DrawHistogram(const char* phase, uint64_t windowNs, const char* label,
+                   int x, int y) {
+    int buckets[BUCKETS];
+    klondike::Profiler::instance().histogram(phase, windowNs, buckets,
+                                             BUCKETS, 1.0);
+    int highest = 1;
+    for (int count : buckets) highest = count > highest ? count : highest;
+    const int barWidth = (WIDTH - 20) / BUCKETS;
+    DrawText(label, x + 10, y, 10, LIGHTGRAY);
+    for (int i = 0; i < BUCKETS; ++i) {
+        const int bar = buckets[i] * HISTOGRAM_HEIGHT / highest;
+        // Green fits 60 fps, yellow 30 fps, red is a visible hitch.
+        const Color color = i < 17 ? GREEN : i < 33 ? YELLOW : RED;
+        DrawRectangle(x + 10 + i * barWidth,
+                      y + LINE + HISTOGRAM_HEIGHT - bar, barWidth - 1, bar,
+                      color);
+    }
+}
+
+}  // namespace
+
+void DrawProfilerOverlay(int x, int y) {
+    klondike::Profiler& profiler = klondike::Profiler::instance();
+    const int histogram = LINE + HISTOGRAM_HEIGHT + 10;
+    const int height = 20 + 2 * histogram + (PHASE_COUNT + 1) * LINE;
+    DrawRectangle(x, y, WIDTH, height, Fade(BLACK, 0.7f));
+
+    DrawHistogram(PHASE_FRAME, WINDOW_NS, "frame time", x, y + 10);
+    DrawHistogram(PHASE_INPUT_LATENCY, LATENCY_WINDOW_NS,
+                  "input to screen, last 30 s", x, y + 10 + histogram);
+
+    // The default font is proportional, so each column gets its own x.
+    int line = y + 10 + 2 * histogram;
+    const char* headings[] = {"phase", "p50 ms", "p99 ms", "max ms"};
+    const int columns[] = {x + 10, x + 130, x + 185, x + 240};
+    for (int i = 0; i < 4; ++i) {
+        DrawText(headings[i], columns[i], line, 10, LIGHTGRAY);
+    }
+    for (const char* phase : phases) {
+        line += LINE;
+        klondike::Profiler::Summary summary =
+            profiler.summarize(phase, WINDOW_NS);
+        DrawText(phase, columns[0], line, 10, RAYWHITE);
+        DrawText(TextFormat("%.3f", summary.p50Ms), columns[1], line, 10,
+                 RAYWHITE);
+        DrawText(TextFormat("%.3f", summary.p99Ms), columns[2], line, 10,
+                 RAYWHITE);
+        DrawText(TextFormat("%.3f", summary.maxMs), columns[3], line, 10,
+                 RAYWHITE);
+    }
+}
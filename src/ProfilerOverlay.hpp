@@ -0,0 +1,20 @@
+#pragma once
+
+// Names the game loop records its phases under. Samples are matched by
+// pointer, so always use these rather than equal strings.
+inline constexpr const char* PHASE_FRAME = "frame";
+inline constexpr const char* PHASE_INPUT = "input";
+inline constexpr const char* PHASE_LAYOUT = "layout";
+inline constexpr const char* PHASE_DRAW_TABLE = "drawTable";
+inline constexpr const char* PHASE_DRAW_HIDDEN_POOL = "drawHiddenPool";
+inline constexpr const char* PHASE_DRAW_STATIC = "drawStatic";
+inline constexpr const char* PHASE_DRAW_MOVING = "drawMoving";
+inline constexpr const char* PHASE_DRAW_DRAGGED = "drawDragged";
+inline constexpr const char* PHASE_FLUSH = "flush";
+inline constexpr const char* PHASE_END_DRAWING = "EndDrawing";
+// From an input to the end of the frame showing its result.
+inline constexpr const char* PHASE_INPUT_LATENCY = "inputLatency";
+
+// Frame-time and input-latency histograms, and p50/p99 of every phase over
+// the last couple of seconds, in a box with its top-left corner at (x, y).
+void DrawProfilerOverlay(int x, int y);
@@ -0,0 +1,116 @@
+#include "ScaledTexture.hpp"
+#include <algorithm>
+#include <utility>
+#include "ImageLoader.hpp"
+
+void ScaledTexture::load(Image source, std::string spillPath) {
+    source_ = source;
+    spillPath_ = std::move(spillPath);
+    sourceWidth_ = source.width;
+    sourceHeight_ = source.height;
+    rescalable_ = true;
+    texture_ = LoadTextureFromImage(source_);
+    GenTextureMipmaps(&texture_);
+    SetTextureFilter(texture_, TEXTURE_FILTER_TRILINEAR);
+    wantedWidth_ = texture_.width;
+    wantedHeight_ = texture_.height;
+
+    if (spillPath_.empty()) return;
+    // Queued ahead of any rebuild, which then finds the source on disk.
+    pool_.submit([this] {
+        if (ImageLoader::writeRaw(spillPath_, source_)) {
+            UnloadImage(source_);
+            source_ = {};
+        } else {
+            TraceLog(LOG_WARNING,
+                     "TEXTURES: cannot write %s, keeping the source in memory",
+                     spillPath_.c_str());
+        }
+    });
+}
+
+void ScaledTexture::request(int width, int height) {
+    if (!rescalable_) return;
+    wantedWidth_ = std::clamp(width, 1, sourceWidth_);
+    wantedHeight_ = std::clamp(height, 1, sourceHeight_);
+    if (!building_) start();
+}
+
+void ScaledTexture::start() {
+    if (!rescalable_ or (wantedWidth_ == texture_.width and
+                         wantedHeight_ == texture_.height)) {
+        return;
+    }
+    building_ = true;
+    // Without a spill file the source goes to this one rebuild.
+    const bool last = spillPath_.empty();
+    rescalable_ = !last;
+    const int width = wantedWidth_;
+    const int height = wantedHeight_;
+    pool_.submit([this, width, height, last] {
+        Image image = {};
+        if (last) {
+            image = std::exchange(source_, Image{});
+        } else if (source_.data != nullptr) {
+            image = ImageCopy(source_);
+        } else if (!ImageLoader::readRaw(spillPath_, image)) {
+            image = {};
+        }
+        if (image.data != nullptr) {
+            ImageResize(&image, width, height);
+            ImageMipmaps(&image);
+        }
+        built_ = image;
+        ready_.store(true, std::memory_order_release);
+    });
+}
+
+bool ScaledTexture::poll() {
+    if (!building_ or !ready_.load(std::memory_order_acquire)) return false;
+    ready_.store(false, std::memory_order_relaxed);
+    building_ = false;
+
+    Texture2D texture =
+        built_.data != nullptr ? LoadTextureFromImage(built_) : Texture2D{};
+    if (texture.id == 0) {
+        // Keep what is there rather than retrying every poll.
+        TraceLog(LOG_WARNING, "TEXTURES: cannot rebuild at %dx%d",
+                 wantedWidth_, wantedHeight_);
+        UnloadImage(built_);
+        built_ = {};
+        wantedWidth_ = texture_.width;
+        wantedHeight_ = texture_.height;
+        return false;
+    }
+    UnloadImage(built_);
+    built_ = {};
+    SetTextureFilter(texture, TEXTURE_FILTER_TRILINEAR);
+    UnloadTexture(texture_);
+    texture_ = texture;
+    ++rebuilds_;
+    // Asked for another size in the meantime.
+    start();
+    return true;
+}
+
+void ScaledTexture::unload() {
+    pool_.wait();
+    if (ready_.exchange(false)) UnloadImage(built_);
+    built_ = {};
+    building_ = false;
+    if (texture_.id != 0) UnloadTexture(texture_);
+    texture_ = {};
+    if (source_.data != nullptr) UnloadImage(source_);
+    source_ = {};
+    rescalable_ = false;
+}
+
+std::size_t ScaledTexture::bytes() const {
+    std::size_t total = 0;
+    for (int level = 0; level < texture_.mipmaps; ++level) {
+        const int width = std::max(1, texture_.width >> level);
+        const int height = std::max(1, texture_.height >> level);
+        total += std::size_t(GetPixelDataSize(width, height, texture_.format));
+    }
+    return total;
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include "raylib.h"
+#include "ThreadPool.hpp"
+
+// A texture kept at the size it is drawn at, regenerated from its
+// full-resolution source. Scaling and building the mip chain run on a
+// worker thread; the result is uploaded and swapped in by poll() on the
+// main thread, the only one with the GL context.
+//
+// The source does not stay in memory. A texture that is only ever wanted
+// at one size hands it to that single rebuild; one rebuilt on every resize
+// writes it to a spill file in ImageLoader's cache format and reads it
+// back for each rebuild. Only if the spill file cannot be written is the
+// source kept in memory instead.
+//
+// Every version carries a full mip chain and is sampled trilinearly, so
+// while the copy for a new size is being built the old one still shrinks
+// cleanly, as do cards narrowed by a flip.
+class ScaledTexture {
+   public:
+    ScaledTexture() : pool_(1) {}
+    ~ScaledTexture() { pool_.wait(); }
+
+    ScaledTexture(const ScaledTexture&) = delete;
+    ScaledTexture& operator=(const ScaledTexture&) = delete;
+
+    // Takes `source` (R8G8B8A8) over and uploads it as it is until the
+    // first rebuild lands. With no `spillPath`, only the first request()
+    // is built and later ones are ignored.
+    void load(Image source, std::string spillPath = "");
+    // Asks for a copy of `width` x `height`, capped at the source size.
+    // One rebuild runs at a time; the last size asked for while it runs is
+    // built next.
+    void request(int width, int height);
+    // Swaps in a finished rebuild. True if the texture changed.
+    bool poll();
+    void unload();
+
+    const Texture2D& texture() const { return texture_; }
+    // GPU memory of the texture including its mip chain.
+    std::size_t bytes() const;
+    int rebuilds() const { return rebuilds_; }
+
+   private:
+    void start();
+
+    std::string spillPath_;
+    int sourceWidth_ = 0;
+    int sourceHeight_ = 0;
+    bool rescalable_ = false;
+    Texture2D texture_ = {};
+    int wantedWidth_ = 0;
+    int wantedHeight_ = 0;
+    bool building_ = false;
+    int rebuilds_ = 0;
+
+    klondike::ThreadPool pool_;
+    // Both only touched by the worker until ready_ or pool_.wait().
+    Image source_ = {};  // until spilled or handed to the one rebuild
+    Image built_ = {};
+    std::atomic<bool> ready_{false};
+};
@@ -0,0 +1,62 @@
+#include "SpriteBatch.hpp"
+#include "rlgl.h"
+
+void SpriteBatch::begin(Texture2D texture) {
+    begin(texture, {float(texture.width), float(texture.height)});
+}
+
+void SpriteBatch::begin(Texture2D texture, Vector2 sourceSize) {
+    texture_ = texture;
+    sourceSize_ = sourceSize;
+    count_ = 0;
+}
+
+void SpriteBatch::draw(Rectangle source, Rectangle dest, Color tint) {
+    if (count_ == CAPACITY) flush();
+    quads_[count_++] = {source, dest, tint};
+}
+
+void SpriteBatch::end() { flush(); }
+
+void SpriteBatch::newFrame() {
+    last_ = current_;
+    current_ = {};
+}
+
+void SpriteBatch::flush() {
+    if (count_ == 0) return;
+
+    const float width = sourceSize_.x;
+    const float height = sourceSize_.y;
+    rlCheckRenderBatchLimit(4 * count_);
+    rlSetTexture(texture_.id);
+    rlBegin(RL_QUADS);
+    rlNormal3f(0.0f, 0.0f, 1.0f);
+    for (int i = 0; i < count_; ++i) {
+        const Quad& quad = quads_[i];
+        const float u0 = quad.source.x / width;
+        const float v0 = quad.source.y / height;
+        const float u1 = (quad.source.x + quad.source.width) / width;
+        const float v1 = (quad.source.y + quad.source.height) / height;
+        const float x0 = quad.dest.x;
+        const float y0 = quad.dest.y;
+        const float x1 = quad.dest.x + quad.dest.width;
+        const float y1 = quad.dest.y + quad.dest.height;
+
+        rlColor4ub(quad.tint.r, quad.tint.g, quad.tint.b, quad.tint.a);
+        rlTexCoord2f(u0, v0);
+        rlVertex2f(x0, y0);
+        rlTexCoord2f(u0, v1);
+        rlVertex2f(x0, y1);
+        rlTexCoord2f(u1, v1);
+        rlVertex2f(x1, y1);
+        rlTexCoord2f(u1, v0);
+        rlVertex2f(x1, y0);
+    }
+    rlEnd();
+    rlSetTexture(0);
+
+    ++current_.drawCalls;
+    current_.quads += count_;
+    count_ = 0;
+}
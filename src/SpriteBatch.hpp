@@ -0,0 +1,42 @@
+#pragma once
+#include "raylib.h"
+
+// Collects textured quads from one texture and submits them between a
+// single rlBegin/rlEnd, i.e. one draw call per flush.
+class SpriteBatch {
+   public:
+    struct Stats {
+        int drawCalls;
+        int quads;
+    };
+
+    void begin(Texture2D texture);
+    // For a texture drawn from a scaled copy: source rectangles are in the
+    // pixels of the `sourceSize` original.
+    void begin(Texture2D texture, Vector2 sourceSize);
+    void draw(Rectangle source, Rectangle dest, Color tint = WHITE);
+    void end();
+
+    // Call once per frame; lastFrame() then reports the frame before.
+    void newFrame();
+    Stats lastFrame() const { return last_; }
+
+   private:
+    struct Quad {
+        Rectangle source;
+        Rectangle dest;
+        Color tint;
+    };
+
+    // A full table is well under 100 quads; more than this just flushes.
+    static constexpr int CAPACITY = 256;
+
+    void flush();
+
+    Texture2D texture_;
+    Vector2 sourceSize_;
+    Quad quads_[CAPACITY];
+    int count_ = 0;
+    Stats current_ = {};
+    Stats last_ = {};
+};
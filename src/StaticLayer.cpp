@@ -0,0 +1,42 @@
+#include "StaticLayer.hpp"
+
+bool StaticLayer::beginRepaint(const klondike::State& state) {
+    const int width = GetScreenWidth();
+    const int height = GetScreenHeight();
+    if (target_.id == 0 or target_.texture.width != width or
+        target_.texture.height != height) {
+        unload();
+        target_ = LoadRenderTexture(width, height);
+        valid_ = false;
+    }
+    if (valid_ and state == painted_) return false;
+
+    painted_ = state;
+    valid_ = true;
+    ++repaints_;
+    BeginTextureMode(target_);
+    return true;
+}
+
+void StaticLayer::endRepaint() { EndTextureMode(); }
+
+void StaticLayer::draw() const {
+    // Render textures come out upside down, hence the negative height.
+    const Texture2D& texture = target_.texture;
+    DrawTextureRec(texture,
+                   {0, 0, float(texture.width), -float(texture.height)},
+                   {0, 0}, WHITE);
+}
+
+void StaticLayer::unload() {
+    if (target_.id != 0) UnloadRenderTexture(target_);
+    target_ = {};
+    valid_ = false;
+}
+
+std::size_t StaticLayer::bytes() const {
+    const Texture2D& texture = target_.texture;
+    if (target_.id == 0) return 0;
+    return std::size_t(
+        GetPixelDataSize(texture.width, texture.height, texture.format));
+}
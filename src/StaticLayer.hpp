@@ -0,0 +1,33 @@
+#pragma once
+#include <cstddef>
+#include "raylib.h"
+#include "Klondike.hpp"
+
+// The parts of the table that only change when a move is made or the
+// window is resized: background, slots, face-down cards, the stock and the
+// home cells. They are painted into a window-sized render texture and
+// composited each frame as a single quad.
+class StaticLayer {
+   public:
+    // True if what was painted no longer matches `state` or the window
+    // size. Drawing then goes into the layer until endRepaint().
+    bool beginRepaint(const klondike::State& state);
+    void endRepaint();
+
+    // The layer, covering the whole window.
+    void draw() const;
+
+    // Forces a repaint on the next beginRepaint().
+    void invalidate() { valid_ = false; }
+    void unload();
+
+    uint64_t repaints() const { return repaints_; }
+    // GPU memory of the colour buffer.
+    std::size_t bytes() const;
+
+   private:
+    RenderTexture2D target_ = {};
+    klondike::State painted_ = {};
+    bool valid_ = false;
+    uint64_t repaints_ = 0;
+};
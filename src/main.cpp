@@ -1,343 +1,846 @@
+#include <cassert>
+#include <cstddef>
+#include <cstdio>
+#include <filesystem>
 #include <iostream>
-#include <vector>
-#include <algorithm>
 #include <random>
+#include <string>
 #include "raylib.h"
+#include "Allocations.hpp"
+#include "Args.hpp"
+#include "BackgroundSolver.hpp"
+#include "CardAtlas.hpp"
+#include "DealDb.hpp"
+#include "Game.hpp"
+#include "ImageLoader.hpp"
+#include "Input.hpp"
+#include "Klondike.hpp"
+#include "Layout.hpp"
+#include "MappedFile.hpp"
+#include "Profiler.hpp"
+#include "ProfilerOverlay.hpp"
+#include "Replay.hpp"
+#include "ScaledTexture.hpp"
+#include "Snapshot.hpp"
+#include "SpriteBatch.hpp"
+#include "StaticLayer.hpp"
+#include "Tweens.hpp"
+
+using klondike::Card;
+using klondike::Move;
+using klondike::State;
 
-enum Suit { HEARTS, CLUBS, DIAMONDS, SPADES };
 enum GameState { MENU, GAME, GAME_OVER };
 
-struct Card {
-    Suit suit;
-    int value;
-    bool isFaceUp;
-    Rectangle sourceRect;
-    Vector2 position;
-
-    void drawCard(Vector2 size, Texture2D& facecard, Texture2D& backcard) {
-        if (isFaceUp) {
-            DrawTexturePro(facecard, sourceRect,
-                           {position.x, position.y, size.x, size.y}, {0, 0},
-                           0.0f, WHITE);
-        } else {
-            DrawTexturePro(backcard, sourceRect,
-                           {position.x, position.y, size.x, size.y}, {0, 0},
-                           0.0f, WHITE);
-        }
+// The pile a drag started from and the index of the first dragged card.
+int selectedPile = -1;
+int selectedRow = -1;
+
+// When and where the last press landed, to spot double clicks.
+constexpr double DOUBLE_CLICK_SECONDS = 0.3;
+double lastPressTime = -1;
+klondike::Hit lastPress = {-1, 0};
+
+// The last hint and the position it was given for. It is shown until the
+// position changes or HINT_SECONDS pass; a hint with no cards means there
+// was nothing to suggest.
+constexpr double HINT_SECONDS = 2;
+Move hint = {};
+State hintFor = {};
+double hintUntil = -1;
+
+// Screen-side data for every card, indexed by Card::id(). The rules state in
+// klondike::State knows nothing about textures or positions. `positions`
+// are where cards rest; cards are drawn where `motion` shows them on the
+// way there.
+struct CardViews {
+    klondike::Point positions[klondike::CARD_ID_COUNT];
+    klondike::Tweens motion;
+
+    klondike::Point& position(Card card) { return positions[card.id()]; }
+
+    // Moving or flipping. The piles leave these out; drawMoving() draws
+    // them over everything else.
+    bool isMoving(Card card) const { return motion.isAnimating(card.id()); }
+
+    // Puts `card` at `at` with no motion, as when dragging it.
+    void place(Card card, klondike::Point at) {
+        position(card) = at;
+        motion.place(card, at);
     }
 
-    void faceToggle() {
-        if (this->isFaceUp) {
-            isFaceUp = false;
-        } else {
-            isFaceUp = true;
-        }
-    }
-
-    bool suitReliable(Card secondCard) {
-        switch (this->suit) {
-            case HEARTS:
-                switch (secondCard.suit) { 
-                    case HEARTS:
-                        return false;
-                    case CLUBS:
-                        return true;
-                    case DIAMONDS:
-                        return false;
-                    case SPADES:
-                        return true;
-                }
-            case CLUBS:
-                switch (secondCard.suit) {
-                    case HEARTS:
-                        return true;
-                    case CLUBS:
-                        return false;
-                    case DIAMONDS:
-                        return true;
-                    case SPADES:
-                        return false;
-                }
-            case DIAMONDS:
-                switch (secondCard.suit) {
-                    case HEARTS:
-                        return false;
-                    case CLUBS:
-                        return true;
-                    case DIAMONDS:
-                        return false;
-                    case SPADES:
-                        return true;
-                }
-            case SPADES:
-                switch (secondCard.suit) {
-                    case HEARTS:
-                        return true;
-                    case CLUBS:
-                        return false;
-                    case DIAMONDS:
-                        return true;
-                    case SPADES:
-                        return false;
-                }
+    static Rectangle sourceRect(Card card) {
+        return card.isFaceUp() ? CardAtlas::face(card) : CardAtlas::back();
+    }
+
+    void drawCard(Card card, Vector2 size, SpriteBatch& batch) {
+        const klondike::Tweens::Pose pose = motion.pose(card.id());
+        if (pose.previousFace) {
+            card = card.isFaceUp() ? card.faceDown() : card.faceUp();
         }
+        const float width = size.x * pose.width;
+        batch.draw(sourceRect(card),
+                   {pose.position.x + (size.x - width) / 2, pose.position.y,
+                    width, size.y});
     }
 
-    void setCardRectangle() {
-        int column = value - 1;
-        int row = static_cast<int>(suit);
-        sourceRect = {column * 225.0f, row * 315.0f, 225, 315};
+    void drawMoving(Vector2 size, SpriteBatch& batch) {
+        Card moving[klondike::CARD_ID_COUNT];
+        const int count = motion.drawOrder(moving);
+        for (int i = 0; i < count; ++i) drawCard(moving[i], size, batch);
     }
 };
 
-class MainDeck {
-   public:
-    std::vector<Card> cards;
-
-    void initializeDeck(Vector2 size) {
-        for (int suit = HEARTS; suit <= SPADES; ++suit) {
-            for (int value = 1; value <= 13; ++value) {
-                Card card = {static_cast<Suit>(suit), value, false};
-                card.setCardRectangle();
-                cards.push_back(card);
+Rectangle ToRectangle(klondike::Rect rect) {
+    return {rect.x, rect.y, rect.width, rect.height};
+}
+
+Vector2 ToVector2(klondike::Point point) { return {point.x, point.y}; }
+
+// Where the background goes, top left, whatever the window size.
+constexpr int BACKGROUND_WIDTH = 200;
+constexpr int BACKGROUND_HEIGHT = 300;
+
+// GPU memory the table is drawn from.
+std::size_t TextureBytes(const CardAtlas& atlas,
+                         const ScaledTexture& background,
+                         const StaticLayer& layer) {
+    return atlas.bytes() + background.bytes() + layer.bytes();
+}
+
+// Moves played through PlayMove so far, to tell whether an input played
+// one. The undo log cannot: its size stops growing once it is full.
+uint64_t movesPlayed = 0;
+
+// Every move the player makes goes through here so the layout knows which
+// piles to lay out again.
+void PlayMove(klondike::Game& game, klondike::Layout& layout, Move move) {
+    klondike::AllocationScope allocations;
+    if (game.play(move)) {
+        layout.markDirty(move);
+        ++movesPlayed;
+    }
+    assert(allocations.count() == 0);
+}
+
+// Ticks between cards sent home by AutoComplete.
+constexpr int CASCADE_TICKS = 5;
+
+// With the talon gone and every card face up the game is as good as won,
+// so it is played out: the lowest top card goes home each time, and the
+// cards fly there one after another.
+void AutoComplete(klondike::Game& game, klondike::Layout& layout,
+                  CardViews& views) {
+    const State& state = game.state();
+    if (state.talonSize > 0 or state.isWon()) return;
+    for (int i = 0; i < klondike::TABLEAU_COUNT; ++i) {
+        for (Card card : state.column(i)) {
+            if (!card.isFaceUp()) return;
+        }
+    }
+    for (int delay = 0; !state.isWon(); delay += CASCADE_TICKS) {
+        Move move = {};
+        int lowest = klondike::KING + 1;
+        for (int i = 0; i < klondike::TABLEAU_COUNT; ++i) {
+            if (state.columnSize(i) == 0) continue;
+            const Card card = state.top(klondike::TABLEAU + i);
+            if (card.value() < lowest) {
+                lowest = card.value();
+                move = {uint8_t(klondike::TABLEAU + i),
+                        uint8_t(klondike::FOUNDATION + int(card.suit())), 1};
             }
         }
-        shuffleDeck();
+        // Each column is one run once every card is face up, so the lowest
+        // top card always fits; this only guards against a bug.
+        if (lowest > klondike::KING or
+            !game.legalMoves().count(move.from, move.to)) {
+            return;
+        }
+        const Card card = state.top(move.from);
+        PlayMove(game, layout, move);
+        const klondike::Rect home = layout.slot(move.to);
+        views.motion.moveTo(card, {home.x, home.y}, delay);
     }
+}
 
-    void shuffleDeck() {
-        std::random_device rd;
-        std::mt19937 g(rd());
-        std::shuffle(cards.begin(), cards.end(), g);
+// Keeps the background solver on the current position and shows what it
+// has worked out about it. Nothing here waits for the search.
+class WinIndicator {
+   public:
+    explicit WinIndicator(klondike::SolverLimits limits) : solver_(limits) {}
+
+    // Call once a frame, drawn or not. True if what draw() shows has
+    // changed.
+    bool update(const State& game) {
+        bool changed = false;
+        if (!(game == analyzed_)) {
+            analyzed_ = game;
+            position_ = solver_.analyze(game);
+            changed = true;
+        }
+        return solver_.poll(analysis_) or changed;
+    }
+
+    // The first move of a win the solver found from here, if it has one.
+    bool bestMove(Move& move) const {
+        if (!isCurrent() or !analysis_.hasMove) return false;
+        move = analysis_.bestMove;
+        return true;
     }
 
-    Card takeCard() {
-        Card card = cards.back();
-        cards.pop_back();
-        return card;
+    void draw(int x, int y) const {
+        if (!isCurrent()) {
+            DrawText("Thinking...", x, y, 10, DARKGRAY);
+        } else if (analysis_.verdict == klondike::SOLVED) {
+            DrawText("Winnable", x, y, 10, DARKGREEN);
+        } else if (analysis_.verdict == klondike::UNSOLVABLE) {
+            DrawText("No way to win from here", x, y, 10, MAROON);
+        } else {
+            DrawText(TextFormat("Unknown after %.1fM positions",
+                                double(analysis_.nodes) / 1e6),
+                     x, y, 10, DARKGRAY);
+        }
     }
 
-    bool isEmpty() { return cards.empty(); }
+   private:
+    bool isCurrent() const { return analysis_.position == position_; }
+
+    klondike::BackgroundSolver solver_;
+    State analyzed_ = {};
+    uint64_t position_ = 0;
+    klondike::Analysis analysis_;
 };
 
-class HiddenPool {
+// H asks for a hint: the background solver's move when it has found a win,
+// otherwise the best-looking legal move. Neither waits on anything.
+// `outlook` is null when the solver does not know the variant's rules.
+void HandleHintKey(const klondike::Game& game, const WinIndicator* outlook,
+                   const InputEvent& event) {
+    if (event.kind != KEY or event.key != KEY_H) return;
+    // The outlook only catches up once a frame, so after a move or undo
+    // earlier in the same frame its move is for the previous position.
+    const bool solved =
+        outlook and outlook->bestMove(hint) and
+        game.legalMoves().count(hint.from, hint.to) == hint.count;
+    if (!solved and !game.hint(hint)) hint = {};
+    hintFor = game.state();
+    hintUntil = GetTime() + HINT_SECONDS;
+}
+
+// Outlines the cards the hint would move and where they would go. Once the
+// hint has run out hintUntil goes back to -1, so no more frames are drawn
+// for it.
+void DrawHint(const State& game, CardViews& views, klondike::Layout& layout) {
+    if (GetTime() > hintUntil) hintUntil = -1;
+    if (hintUntil < 0 or !(game == hintFor)) return;
+    if (hint.count == 0) {
+        DrawText("No useful moves", 10, GetScreenHeight() - 40, 20, GOLD);
+        return;
+    }
+
+    const klondike::Point size = layout.cardSize();
+    klondike::Rect from = layout.slot(hint.from);
+    if (hint.from != klondike::STOCK) {
+        const int first = game.pileSize(hint.from) - hint.count;
+        const klondike::Point top =
+            hint.from == klondike::WASTE
+                ? views.position(game.top(klondike::WASTE))
+                : views.position(game.column(hint.from)[first]);
+        const klondike::Point bottom = views.position(game.top(hint.from));
+        from = {top.x, top.y, size.x, bottom.y - top.y + size.y};
+    }
+    klondike::Rect to = layout.slot(hint.to);
+    if (klondike::isTableau(hint.to) and game.columnSize(hint.to) > 0) {
+        const klondike::Point top = views.position(game.top(hint.to));
+        to = {top.x, top.y, size.x, size.y};
+    }
+    DrawRectangleLinesEx(ToRectangle(from), 4, GOLD);
+    DrawRectangleLinesEx(ToRectangle(to), 4, GOLD);
+}
+
+// A second press on the same card soon after the first sends it, and the
+// cards on it, to the best pile that takes them.
+bool CheckDoubleClick(klondike::Game& game, klondike::Layout& layout,
+                      klondike::Hit hit, const InputEvent& event) {
+    const double now = double(event.timeNs) / 1e9;
+    const bool twice = now - lastPressTime < DOUBLE_CLICK_SECONDS and
+                       hit.pile == lastPress.pile and
+                       hit.index == lastPress.index;
+    lastPressTime = twice ? -1 : now;
+    lastPress = hit;
+    if (!twice) return false;
+
+    Move move;
+    const int count = game.state().pileSize(hit.pile) - hit.index;
+    if (!game.bestTarget(hit.pile, count, move)) return false;
+    PlayMove(game, layout, move);
+    return true;
+}
+
+// Ctrl+Z takes a move back, Ctrl+Y (or Ctrl+Shift+Z) plays it again. Not
+// while dragging, since the dragged cards might be the ones to move.
+void HandleHistoryKey(klondike::Game& game, klondike::Layout& layout,
+                      const InputEvent& event) {
+    if (selectedPile != -1 or event.kind != KEY or !event.control) return;
+
+    Move changed;
+    if (event.key == KEY_Z and !event.shift) {
+        if (game.undo(changed)) layout.markDirty(changed);
+    } else if (event.key == KEY_Y or (event.key == KEY_Z and event.shift)) {
+        if (game.redo(changed)) layout.markDirty(changed);
+    }
+}
+
+class MainDeck {
    public:
-    std::vector<Card> cards;
-    std::vector<Card> buffer;
-    Vector2 position;
+    klondike::Deck cards;
+    // Everything about the deal follows from this; print it in bug reports.
+    uint64_t seed;
 
-    void initializeHiddenPool(MainDeck& deck) {
-        position = {float(GetScreenWidth()) / 8, float(GetScreenHeight()) / 16};
-        while (!deck.isEmpty()) {
-            cards.push_back(deck.takeCard());
-            cards.back().position = position;
-        }
+    void initializeDeck(uint64_t dealSeed) {
+        seed = dealSeed;
+        shuffleDeck();
     }
 
-    void showNextCard(Vector2 size) { 
-        if (!cards.empty()) {
-            Card card = cards.back();
-            card.position.x = position.x + (size.x * 5/4);
-            card.isFaceUp = true;
-            buffer.push_back(card);
-            cards.pop_back();
+    void shuffleDeck() { cards = klondike::shuffledDeck(seed); }
 
-            for (auto card : buffer) {
-                std::cout << card.suit << " " << card.value << '\n';
-            }
-        } else {
-            for (auto card : buffer) {
-                card.position = position;
-                card.isFaceUp = false;
-                cards.push_back(card);
-            }
-            buffer.clear();
-        }
+    static uint64_t randomSeed() {
+        std::random_device rd;
+        return (uint64_t(rd()) << 32) | rd();
     }
+};
 
-    void updateCoords() {
-        position = {float(GetScreenWidth()) / 8, float(GetScreenHeight()) / 16};
+// A deal the solver has won, at `difficulty` (0 easiest), from the deal
+// database at `path`. Mapping the file and indexing a bucket is all it
+// takes, so startup never waits on the solver. False, with a warning, if
+// there is no such deal.
+bool PickGradedSeed(const std::string& path, int difficulty, uint64_t& seed) {
+    const uint64_t startNs = klondike::Profiler::nowNs();
+    klondike::MappedFile file;
+    klondike::DealDb deals;
+    if (!file.open(path.c_str(), klondike::MappedFile::RANDOM) or
+        !deals.attach(file.bytes())) {
+        TraceLog(LOG_WARNING, "DEALS: %s is not a deal database", path.c_str());
+        return false;
+    }
+    if (difficulty < 0 or difficulty >= deals.buckets() or
+        deals.count(difficulty) == 0) {
+        TraceLog(LOG_WARNING,
+                 "DEALS: no winnable deals at difficulty %d of 0-%d in %s",
+                 difficulty, deals.buckets() - 1, path.c_str());
+        return false;
     }
+    const uint32_t count = deals.count(difficulty);
+    const klondike::DealRecord deal =
+        deals.record(difficulty, uint32_t(MainDeck::randomSeed() % count));
+    seed = deal.seed;
+    TraceLog(LOG_INFO,
+             "DEALS: difficulty %d, one of %u, won by the solver in %u moves; "
+             "picked in %.1f us",
+             difficulty, count, unsigned(deal.moves),
+             double(klondike::Profiler::nowNs() - startNs) / 1e3);
+    return true;
+}
 
-    void drawHiddenPool(Texture2D& facecard, Texture2D& backcard,
-                        Vector2 size) {
-        for (int i = 0; i < cards.size(); i++) {
-             cards[i].drawCard(size, facecard, backcard);
-        }
-        for (int i = 0; i < buffer.size(); i++) {
-            buffer[i].drawCard(size, facecard, backcard);
-        }
+// Plays a recorded game back in the window at `speed` times the pace it was
+// played. Input is ignored meanwhile.
+class ReplayPlayer {
+   public:
+    // Reads the first game of the file; `seed` and `variant` are the deal
+    // to start from.
+    bool open(const char* path, uint64_t& seed, klondike::Variant& variant) {
+        if (!file_.open(path)) return false;
+        reader_ = klondike::ReplayReader(file_.bytes());
+        active_ = reader_.nextGame(seed, variant);
+        pending_ = active_ and reader_.next(next_);
+        return active_;
     }
 
-    void refreshPositions(Vector2 size) { 
-        for (int i = 0; i < cards.size(); i++) {
-            cards[i].position = position;
+    bool isActive() const { return active_; }
+
+    void update(klondike::Game& game, klondike::Layout& layout, float seconds,
+                float speed) {
+        if (!active_) return;
+        elapsedMs_ += seconds * speed * 1000.f;
+        Move changed;
+        while (pending_ and elapsedMs_ >= float(next_.delayMs)) {
+            elapsedMs_ -= float(next_.delayMs);
+            if (!game.play(next_, changed)) {
+                TraceLog(LOG_WARNING, "REPLAY: event does not fit, stopping");
+                pending_ = false;
+                break;
+            }
+            layout.markDirty(changed);
+            pending_ = reader_.next(next_);
         }
-        for (int i = 0; i < buffer.size(); i++) {
-            buffer[i].position.x = position.x + (size.x * 5/4);
-            buffer[i].position.y = position.y;
+        if (!pending_ and reader_.corrupt()) {
+            TraceLog(LOG_WARNING, "REPLAY: file is damaged, stopping");
         }
     }
 
+   private:
+    klondike::MappedFile file_;
+    klondike::ReplayReader reader_;
+    klondike::ReplayEvent next_;
+    bool active_ = false;
+    bool pending_ = false;
+    float elapsedMs_ = 0;
 };
 
-class Table {
+class HiddenPool {
    public:
-    std::vector<Card> columns[7];
-
-    void initializeTable(MainDeck& deck, Vector2 size, HiddenPool& hiddenPool) {
-        for (int i = 0; i < 7; ++i) {
-            Vector2 position = {float(GetScreenWidth()/8 + i * (size.x + size.x/20)), hiddenPool.position.y + size.y + size.y * 5/30};
-            for (int j = 0; j <= i; ++j) {
-                Card card = deck.takeCard();
-                card.position = position;
-                if (j == i) card.isFaceUp = true;
-                columns[i].push_back(card);
-                position.y += 30;
+    // Draws as many cards as the variant does, or turns the waste over
+    // if the variant still allows another pass.
+    void showNextCard(klondike::Game& game, klondike::Layout& layout) {
+        const klondike::MoveMatrix& moves = game.legalMoves();
+        for (auto [from, to] : {std::pair{klondike::STOCK, klondike::WASTE},
+                                std::pair{klondike::WASTE, klondike::STOCK}}) {
+            if (int count = moves.count(from, to)) {
+                PlayMove(game, layout,
+                         {uint8_t(from), uint8_t(to), uint8_t(count)});
+                return;
             }
         }
     }
 
-    void refreshPositions(Vector2 size, HiddenPool& hiddenPool) {
-        for (int i = 0; i < 7; ++i) {
-            Vector2 position = {
-                float(GetScreenWidth() / 8 + i * (size.x + size.x / 20)),
-                                hiddenPool.position.y + size.y + size.y * 5/30};
-            for (size_t j = 0; j < columns[i].size(); ++j) {
-                columns[i][j].position = position;
-                position.y += 30;
+    // Both piles are squared up, so only the top card of each can be seen
+    // (or the one under the waste top while that is being dragged), or
+    // the first one under any on the move. The stock is part of the static
+    // layer.
+    void drawStock(const State& game, CardViews& views, SpriteBatch& batch,
+                   Vector2 size) {
+        for (Card card : game.stock()) {
+            if (!views.isMoving(card)) {
+                views.drawCard(card, size, batch);
+                break;
             }
         }
     }
 
-    void drawTable(Vector2 size, Texture2D& facecard, Texture2D& backcard, Texture2D& cock, HiddenPool& hiddenPool) {
-        for (int i = 0; i < 7; ++i) {
-            if (!columns[i].empty()) {
-                for (size_t j = 0; j < columns[i].size(); ++j) {
-                    columns[i][j].drawCard(size, facecard, backcard);
-                }
-            } else {
-                Vector2 position = {
-                    float(GetScreenWidth() / 8 + i * (size.x + size.x / 20)),
-                    hiddenPool.position.y + size.y + size.y * 5 / 30};
-                DrawTexturePro(cock, {0, 0, 225, 315}, {position.x, position.y, size.x, size.y}, {0, 0}, 0.0f, WHITE);
-            }
+    void drawWaste(const State& game, CardViews& views, SpriteBatch& batch,
+                   Vector2 size) {
+        auto waste = game.waste();
+        int visible = int(waste.size()) - (selectedPile == klondike::WASTE);
+        while (visible > 0 and views.isMoving(waste[visible - 1])) --visible;
+        if (visible > 0) {
+            views.drawCard(waste[visible - 1], size, batch);
         }
     }
+};
 
-    void moveCards(int fromColumn, int fromRow, int toColumn) {
-        auto& source = columns[fromColumn];
-        auto& destination = columns[toColumn];
-        destination.insert(destination.end(), source.begin() + fromRow,
-                           source.end());
-        source.erase(source.begin() + fromRow, source.end());
+class Table {
+   public:
+    // Empty-column art and face-down cards, for the static layer. Face-down
+    // cards are always under the face-up ones, so drawing them first keeps
+    // every column in order.
+    void drawColumnBacks(const State& game, CardViews& views, Vector2 size,
+                         SpriteBatch& batch, klondike::Layout& layout) {
+        for (int i = 0; i < klondike::TABLEAU_COUNT; ++i) {
+            if (game.columnSize(i) == 0) {
+                batch.draw(CardAtlas::emptyColumn(),
+                           ToRectangle(layout.slot(klondike::TABLEAU + i)));
+            }
+            for (Card card : game.column(i)) {
+                if (card.isFaceUp()) break;
+                if (!views.isMoving(card)) views.drawCard(card, size, batch);
+            }
+        }
     }
 
-    void moveFromHiddenPool(HiddenPool& hiddenPool, int toColumn) {
-        auto& destination = columns[toColumn];
-        destination.push_back(hiddenPool.buffer.back());
-        hiddenPool.buffer.pop_back();
+    // The face-up cards. Cards being dragged are left out; they are drawn
+    // last, on top.
+    void drawTable(const State& game, CardViews& views, Vector2 size,
+                   SpriteBatch& batch) {
+        for (int i = 0; i < klondike::TABLEAU_COUNT; ++i) {
+            auto column = game.column(i);
+            if (i == selectedPile) column = column.first(selectedRow);
+            for (Card card : column) {
+                if (card.isFaceUp() and !views.isMoving(card)) {
+                    views.drawCard(card, size, batch);
+                }
+            }
+        }
     }
 };
 
 class HomeCell {
    public:
-    std::vector<Card> cells[4];
-    Vector2 position = {float(GetScreenWidth() / 2), float(GetScreenHeight() / 16)
-};
-
-    void drawHomeCells(Vector2 size, Texture2D& facecard, Texture2D& backcard, Texture2D& slot) {
-        for (int i = 0; i < 4; ++i) {
-            if (!cells[i].empty()) {
-                cells[i].back().drawCard(size, facecard, backcard);
+    void drawHomeCells(const State& game, CardViews& views, Vector2 size,
+                       SpriteBatch& batch, klondike::Layout& layout) {
+        for (int i = 0; i < klondike::SUIT_COUNT; ++i) {
+            // The highest card already home; ones on their way are not.
+            int value = game.foundation[i];
+            const klondike::Suit suit = klondike::Suit(i);
+            while (value > 0 and views.isMoving(Card::make(suit, value))) {
+                --value;
+            }
+            if (value > 0) {
+                views.drawCard(Card::make(suit, value, true), size, batch);
             } else {
-                DrawRectangle(position.x + i * (size.x + size.x / 10),
-                              position.y, size.x, size.y, DARKGRAY);
-                DrawTexturePro(slot, {0, 0, 225, 315},
-                               { position.x + i * (size.x + size.x / 10),
-                                position.y, size.x, size.y},
-                               {0, 0}, 0.0f, WHITE);
+                Rectangle cell =
+                    ToRectangle(layout.slot(klondike::FOUNDATION + i));
+                batch.draw(CardAtlas::white(), cell, DARKGRAY);
+                batch.draw(CardAtlas::slot(), cell);
             }
         }
     }
-
-    void updateCoords() {
-        position = {float(GetScreenWidth() / 2), float(GetScreenHeight() / 16)};
-    }
-
-    bool canPlaceCard(Card card) {
-        if (cells[card.suit].empty()) {
-            return card.value == 1;
-        } else {
-            Card topCard = cells[card.suit].back();
-            return topCard.value ==
-                   card.value - 1;
-        }
-    }
-
-    void placeCard(Card card, Vector2 size) { 
-        card.position.x = this->position.x + card.suit * (size.x/10 + size.x);
-        card.position.y = this->position.y;
-        cells[card.suit].push_back(card); 
-    }
 };
 
-Card* selectedCard = nullptr;
-int selectedColumn = -1;
-int selectedRow = -1;
+void HandleMouse(klondike::Game& session, CardViews& views,
+                 HiddenPool& hiddenPool, klondike::Layout& layout,
+                 const InputEvent& event);
 
-void CheckMouseInput(Table& table, HiddenPool& hiddenPool, HomeCell& homeCell,
-                     Vector2 size, Texture2D& facecard, Texture2D& backcard);
+int main(int argc, char** argv) {
+    Args args(argc - 1, argv + 1);
 
-int main() {
     GameState gameState = MENU;
     const int screenWidth = 1000;
     const int screenHeight = 800;
+    uint64_t startNs = klondike::Profiler::nowNs();
+
+    // Decoding overlaps with creating the window; the loader's threads go
+    // away once everything is on the GPU. The atlas and the background are
+    // rebuilt at the size they are shown; the full-size atlas waits in the
+    // cache for window resizes, the background is only needed once.
+    CardAtlas atlas;
+    ScaledTexture background;
+    {
+        ImageLoader images;
+        const int w = int(CardAtlas::CELL_WIDTH);
+        const int h = int(CardAtlas::CELL_HEIGHT);
+        const int facesImage = images.add("../resources/spritesheet.png",
+                                          klondike::RANK_COUNT * w,
+                                          klondike::SUIT_COUNT * h);
+        const int backImage = images.add("../resources/backcard.png", w, h);
+        const int slotImage = images.add("../resources/slot.png", w, h);
+        const int emptyColumnImage =
+            images.add("../resources/niceCock.png", w, h);
+        const int bgImage = images.add("../resources/bg.jpg", 884, 1080);
+
+        InitWindow(screenWidth, screenHeight, "Solitaire");
+        SetWindowState(FLAG_WINDOW_RESIZABLE);
+
+        images.wait();
+        Image loaded[] = {images.take(facesImage), images.take(backImage),
+                          images.take(slotImage),
+                          images.take(emptyColumnImage)};
+        atlas.load(loaded[0], loaded[1], loaded[2], loaded[3],
+                   images.cacheDir() + "/atlas.rgba");
+        for (Image& image : loaded) UnloadImage(image);
+
+        // Always drawn into the same corner, so one rebuild will do.
+        background.load(images.take(bgImage));
+        background.request(BACKGROUND_WIDTH, BACKGROUND_HEIGHT);
+
+        ImageLoader::Stats imageStats = images.stats();
+        TraceLog(LOG_INFO,
+                 "ASSETS: %d from cache, %d decoded, %d placeholders",
+                 imageStats.fromCache, imageStats.decoded,
+                 imageStats.placeholders);
+    }
 
-    InitWindow(screenWidth, screenHeight, "Solitaire");
-    SetWindowState(FLAG_WINDOW_RESIZABLE);
-
-    Texture2D facecard =
-        LoadTextureFromImage(LoadImage("../resources/spritesheet.png"));
-    Texture2D backcard =
-        LoadTextureFromImage(LoadImage("../resources/backcard.png"));
-    Texture2D slot = 
-        LoadTextureFromImage(LoadImage("../resources/slot.png"));
-    Texture2D cock = LoadTextureFromImage(LoadImage("../resources/niceCock.png"));
-    Texture2D bg =
-        LoadTextureFromImage(LoadImage("../resources/bg.jpg"));
+    SpriteBatch batch;
+    bool showStats = false;
+    // F4 shows phase timings, F5 saves the last `--trace-seconds` of them
+    // for chrome://tracing.
+    bool showProfiler = false;
+    const uint64_t traceSeconds = args.number("trace-seconds", 10);
+
+    // `--replay FILE [--speed N]` watches a recorded game instead of
+    // playing; otherwise the game is recorded to `--record FILE`.
+    ReplayPlayer replay;
+    uint64_t replaySeed = 0;
+    // `--variant standard|draw3|vegas|vegas3`; a replay brings its own.
+    klondike::Variant variant = klondike::STANDARD;
+    if (args.has("variant") and
+        !klondike::parseVariant(args.get("variant"), variant)) {
+        TraceLog(LOG_WARNING, "RULES: unknown variant %s, playing standard",
+                 args.get("variant").c_str());
+    }
+    const std::string replayPath = args.get("replay");
+    if (!replayPath.empty() and
+        !replay.open(replayPath.c_str(), replaySeed, variant)) {
+        TraceLog(LOG_WARNING, "REPLAY: cannot read %s", replayPath.c_str());
+    }
 
-    Vector2 cardSize = {GetScreenWidth() / 10, GetScreenHeight() / 6};
+    // `--difficulty N` deals a seed the solver has won, from the buckets of
+    // the deal database `--deals FILE` made by `klonkdike_cli deals`.
+    const bool graded = !replay.isActive() and !args.has("seed") and
+                        args.has("difficulty");
+
+    // The game left open last time is picked up where it was, unless a
+    // deal is asked for with `--seed`, `--difficulty`, `--replay` or
+    // `--new`. It is saved to `--save FILE` every few seconds and on exit.
+    const std::string savePath = args.get("save", "klonkdike.kds");
+    klondike::Game session;
+    bool resumed = false;
+    uint64_t replayBytes = 0;
+    if (!replay.isActive() and !args.has("seed") and !args.has("new") and
+        !graded) {
+        const uint64_t restoreNs = klondike::Profiler::nowNs();
+        resumed =
+            klondike::loadSnapshot(savePath.c_str(), session, &replayBytes);
+        if (resumed) {
+            variant = session.variant();
+            gameState = GAME;
+            TraceLog(LOG_INFO, "SAVE: resumed %s in %.1f us",
+                     savePath.c_str(),
+                     double(klondike::Profiler::nowNs() - restoreNs) / 1e3);
+        }
+    }
+    const klondike::RuleSet rules = klondike::ruleSet(variant);
+    const float replaySpeed = float(args.number("speed", 1));
 
     MainDeck deck;
-    deck.initializeDeck(cardSize);
+    if (!resumed) {
+        uint64_t dealSeed = replay.isActive()  ? replaySeed
+                            : args.has("seed") ? args.number("seed", 0)
+                                               : MainDeck::randomSeed();
+        if (graded) {
+            // Rated by a solver playing draw one with unlimited passes.
+            if (rules.drawCount != 1 or
+                rules.passLimit != klondike::UNLIMITED_PASSES) {
+                TraceLog(LOG_WARNING,
+                         "DEALS: difficulty is rated for draw one with "
+                         "unlimited passes, not %s",
+                         args.get("variant").c_str());
+            }
+            PickGradedSeed(args.get("deals", "deals.kdd"),
+                           int(args.number("difficulty", 0)), dealSeed);
+        }
+        deck.initializeDeck(dealSeed);
+    }
+    const uint64_t seed = resumed ? session.seed() : deck.seed;
+    std::cout << "Deal seed: " << seed << '\n';
+
+    klondike::ReplayWriter recorder;
+    if (!replay.isActive()) {
+        std::string recordPath = args.get("record");
+        if (recordPath.empty()) {
+            std::error_code error;
+            std::filesystem::create_directories("replays", error);
+            recordPath = "replays/" + std::to_string(seed) + ".kdr";
+        }
+        // A resumed game carries on the replay its deal started, cut back
+        // to where the snapshot was taken, as long as that is still there.
+        if (resumed) {
+            if (replayBytes == 0 or
+                !recorder.resume(recordPath.c_str(), replayBytes)) {
+                TraceLog(LOG_INFO,
+                         "REPLAY: %s does not match the save, not recording",
+                         recordPath.c_str());
+            }
+        } else if (!recorder.open(recordPath.c_str())) {
+            TraceLog(LOG_WARNING, "REPLAY: cannot record to %s",
+                     recordPath.c_str());
+        }
+    }
 
+    // The search shares the machine with the game, so keep it modest.
+    klondike::SolverLimits analysisLimits;
+    analysisLimits.memoryBytes = std::size_t(32) << 20;
+    analysisLimits.maxSeconds = 10;
+    WinIndicator outlook(analysisLimits);
+    const bool solvable = rules.drawCount == 1 and
+                          rules.passLimit == klondike::UNLIMITED_PASSES;
+
+    session.record(&recorder);
+    if (!resumed) session.deal(deck.cards, deck.seed, variant);
+    const State& game = session.state();
+
+    CardViews views;
+    klondike::Layout layout;
+    layout.resize(GetScreenWidth(), GetScreenHeight());
+    atlas.fit(layout.cardSize().x, layout.cardSize().y);
     HiddenPool hiddenPool;
     Table table;
-    table.initializeTable(deck, cardSize, hiddenPool);
-    hiddenPool.initializeHiddenPool(deck);
-
     HomeCell homeCell;
 
-    SetTargetFPS(60);
+    // A new deal flies out from the stock; a resumed game is just there.
+    bool snapMotion = resumed;
+    if (!resumed) {
+        const klondike::Rect stock = layout.slot(klondike::STOCK);
+        views.motion.gather({stock.x, stock.y});
+    }
+    double lastAdvance = GetTime();
+
+    uint64_t frameAllocations = 0;
+
+    // The loop runs on a fixed tick well above the frame rate: every pass
+    // polls input and queues it with timestamps, and the simulation then
+    // takes the events due in each tick, however long the last frame took.
+    // Frames are paced by the loop, not raylib, so a slow one does not
+    // also hold up the next poll.
+    constexpr uint64_t TICK_NS = 1'000'000'000 / 240;
+    constexpr double TICK_SECONDS = double(TICK_NS) / 1e9;
+    constexpr uint64_t FRAME_NS = 1'000'000'000 / 60;
+    // A stall (a window drag, a debugger) is not caught up beyond this.
+    constexpr uint64_t MAX_CATCH_UP_NS = 250'000'000;
+    InputQueue input;
+    uint64_t simulatedNs = klondike::Profiler::nowNs();
+    uint64_t nextFrameNs = simulatedNs;
+
+    // Click to photon: from the oldest input not yet on screen to the end
+    // of the frame that shows what it did.
+    LatencyHistogram latency;
+    uint64_t unshownInputNs = 0;
+
+    // A frame is only drawn when something could look different: input,
+    // a move, a resize, a running replay, drag or hint, or news from the
+    // analysis. Otherwise the loop polls and sleeps until the next tick.
+    // `--continuous` draws every frame as before.
+    const bool continuous = args.has("continuous");
+    constexpr double IDLE_REDRAW_SECONDS = 1;
+    bool inputSinceFrame = false;
+    bool resized = false;
+    StaticLayer layer;
+    State shown = game;
+    GameState shownState = gameState;
+    double lastDrawn = -IDLE_REDRAW_SECONDS;
+    uint64_t framesDrawn = 0;
+    uint64_t framesSkipped = 0;
+
+    // What one event does, at the tick it is due.
+    const auto handle = [&](const InputEvent& event) {
+        if (event.kind == KEY and event.key == KEY_F3) {
+            showStats = !showStats;
+        } else if (event.kind == KEY and event.key == KEY_F4) {
+            showProfiler = !showProfiler;
+        } else if (event.kind == KEY and event.key == KEY_F5) {
+            const char* path = "klonkdike_trace.json";
+            if (klondike::Profiler::instance().writeChromeTrace(
+                    path, traceSeconds * 1'000'000'000)) {
+                TraceLog(LOG_INFO, "PROFILER: trace saved to %s", path);
+            } else {
+                TraceLog(LOG_WARNING, "PROFILER: cannot write %s", path);
+            }
+        }
+
+        if (gameState == MENU) {
+            if (event.kind == PRESS or
+                (event.kind == KEY and event.key == KEY_ENTER)) {
+                gameState = GAME;
+            }
+        } else if (gameState == GAME and !replay.isActive()) {
+            const uint64_t played = movesPlayed;
+            HandleHistoryKey(session, layout, event);
+            HandleHintKey(session, solvable ? &outlook : nullptr, event);
+            HandleMouse(session, views, hiddenPool, layout, event);
+            // Only after a move, so undo can take the cascade back a card
+            // at a time.
+            if (movesPlayed > played) {
+                AutoComplete(session, layout, views);
+            }
+        }
+    };
+
+    // Replays are watched, not played, so there is nothing to save.
+    const bool saving = !replay.isActive();
+    constexpr double AUTOSAVE_SECONDS = 5;
+    State saved = game;
+    double lastSaved = GetTime();
 
     while (!WindowShouldClose()) {
-        int width = GetScreenWidth();
-        int height = GetScreenHeight();
-        if (height < width/13*9) {
-            cardSize = {float(GetScreenWidth() / 10),
-                        float(GetScreenWidth() / 10 / 5 * 7)};
-        } else {
-            cardSize = {float(GetScreenHeight() / 6 / 7 * 5),
-                        float(GetScreenHeight() / 6)};
+        uint64_t nowNs = klondike::Profiler::nowNs();
+        input.sample(nowNs);
+        resized = resized or IsWindowResized();
+
+        // Rebuilt textures are swapped in between frames; the static layer
+        // was painted from the old ones.
+        const bool atlasSwapped = atlas.poll();
+        const bool backgroundSwapped = background.poll();
+        const bool texturesSwapped = atlasSwapped or backgroundSwapped;
+        if (texturesSwapped) {
+            layer.invalidate();
+            TraceLog(LOG_INFO,
+                     "TEXTURES: atlas %dx%d, background %dx%d, %.1f MiB "
+                     "with mipmaps and the static layer",
+                     atlas.texture().width, atlas.texture().height,
+                     background.texture().width, background.texture().height,
+                     double(TextureBytes(atlas, background, layer)) /
+                         (1 << 20));
         }
-        
+
+        if (nowNs - simulatedNs > MAX_CATCH_UP_NS) {
+            simulatedNs = nowNs - MAX_CATCH_UP_NS;
+        }
+        {
+            klondike::ProfileScope timer(PHASE_INPUT);
+            for (; simulatedNs + TICK_NS <= nowNs; simulatedNs += TICK_NS) {
+                InputEvent event;
+                while (input.pop(event, simulatedNs + TICK_NS)) {
+                    inputSinceFrame = true;
+                    if (event.kind != DRAG and unshownInputNs == 0) {
+                        unshownInputNs = event.timeNs;
+                    }
+                    handle(event);
+                }
+                if (gameState == GAME and replay.isActive()) {
+                    replay.update(session, layout, float(TICK_SECONDS),
+                                  replaySpeed);
+                }
+            }
+        }
+
+        if (saving and GetTime() - lastSaved >= AUTOSAVE_SECONDS) {
+            lastSaved = GetTime();
+            if (!(game == saved)) {
+                saved = game;
+                if (!klondike::saveSnapshot(session, savePath.c_str(),
+                                            recorder.size())) {
+                    TraceLog(LOG_WARNING, "SAVE: cannot write %s",
+                             savePath.c_str());
+                }
+            }
+        }
+
+        // Updated whether or not the frame is drawn, so a finished analysis
+        // is shown without waiting for input.
+        bool outlookChanged = false;
+        if (gameState == GAME and solvable) {
+            outlookChanged = outlook.update(game);
+        }
+        const bool redraw =
+            nowNs >= nextFrameNs and
+            (continuous or startNs != 0 or inputSinceFrame or resized or
+             texturesSwapped or showStats or showProfiler or outlookChanged or
+             gameState != shownState or !(game == shown) or
+             GetTime() - lastDrawn >= IDLE_REDRAW_SECONDS or
+             (gameState == GAME and
+              (replay.isActive() or selectedPile != -1 or hintUntil >= 0 or
+               views.motion.isAnimating())));
+        if (!redraw) {
+            if (nowNs >= nextFrameNs) {
+                ++framesSkipped;
+                nextFrameNs += FRAME_NS;
+            }
+            PollInputEvents();
+            nowNs = klondike::Profiler::nowNs();
+            if (simulatedNs + TICK_NS > nowNs) {
+                WaitTime(double(simulatedNs + TICK_NS - nowNs) / 1e9);
+            }
+            continue;
+        }
+        ++framesDrawn;
+        lastDrawn = GetTime();
+        // On the 60 Hz grid, unless this frame is already late for it.
+        nextFrameNs = std::max(nextFrameNs + FRAME_NS, nowNs);
+        inputSinceFrame = false;
+
+        klondike::ProfileScope frameTimer(PHASE_FRAME);
+        klondike::AllocationScope allocations;
+        batch.newFrame();
+
+        if (resized) {
+            layout.resize(GetScreenWidth(), GetScreenHeight());
+            atlas.fit(layout.cardSize().x, layout.cardSize().y);
+            snapMotion = true;
+            resized = false;
+        }
+        Vector2 cardSize = ToVector2(layout.cardSize());
 
         switch (gameState) {
             case MENU:
-                if (IsKeyPressed(KEY_ENTER) or IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
-                    gameState = GAME;
-                }
                 BeginDrawing();
                 ClearBackground(RAYWHITE);
                 DrawText("Press ENTER to Start", screenWidth / 4,
@@ -345,39 +848,177 @@ int main() {
                 EndDrawing();
                 break;
             case GAME:
+                {
+                    klondike::ProfileScope timer(PHASE_LAYOUT);
+                    layout.refresh(game, views.positions);
+
+                    // Ticks first, so tweens started below set off from
+                    // where their cards are now. The static layer leaves
+                    // moving cards out, so it is redone whenever the set
+                    // of them changes.
+                    const double now = GetTime();
+                    const bool landed = views.motion.advance(now - lastAdvance);
+                    lastAdvance = now;
+                    if (snapMotion) {
+                        views.motion.snap(game, views.positions);
+                        snapMotion = false;
+                        layer.invalidate();
+                    } else if (views.motion.follow(game, views.positions) or
+                               landed) {
+                        layer.invalidate();
+                    }
+                }
+
+                // Repainted only after a move or a resize; the texture
+                // mode has to be left before BeginDrawing.
+                if (layer.beginRepaint(game)) {
+                    klondike::ProfileScope timer(PHASE_DRAW_STATIC);
+                    ClearBackground(RAYWHITE);
+                    const Texture2D& bg = background.texture();
+                    DrawTexturePro(bg,
+                                   {0, 0, float(bg.width), float(bg.height)},
+                                   {0, 0, BACKGROUND_WIDTH, BACKGROUND_HEIGHT},
+                                   {0, 0}, 0.0f, WHITE);
+                    batch.begin(atlas.texture(), CardAtlas::SIZE);
+                    table.drawColumnBacks(game, views, cardSize, batch,
+                                          layout);
+                    hiddenPool.drawStock(game, views, batch, cardSize);
+                    homeCell.drawHomeCells(game, views, cardSize, batch,
+                                           layout);
+                    batch.end();
+                    layer.endRepaint();
+                }
+
                 BeginDrawing();
                 ClearBackground(RAYWHITE);
+                layer.draw();
+
+                DrawText(TextFormat("Seed %llu",
+                                    static_cast<unsigned long long>(seed)),
+                         10, GetScreenHeight() - 20, 10, DARKGRAY);
+
+                if (rules.scoring != klondike::NO_SCORING) {
+                    DrawText(TextFormat("Score %d", game.score), 10,
+                             GetScreenHeight() - 60, 20, DARKGRAY);
+                }
+                if (rules.passLimit != klondike::UNLIMITED_PASSES) {
+                    DrawText(TextFormat("Passes left %d",
+                                        rules.passLimit - 1 - game.passes),
+                             10, GetScreenHeight() - 80, 10, DARKGRAY);
+                }
 
-                DrawTexturePro(bg, {0, 0, 884, 1080},
-                               {0, 0, 200, 300},
-                    {0, 0}, 0.0f, WHITE);
+                // The solver plays draw one with unlimited passes only.
+                if (solvable) {
+                    outlook.draw(GetScreenWidth() - 160,
+                                 GetScreenHeight() - 20);
+                }
 
-                if (hiddenPool.cards.empty() and hiddenPool.buffer.empty()) {
+                if (game.talonSize == 0) {
 
                     DrawText("Keep going >:')", screenWidth * 3 / 4,
                              screenHeight * 3 / 4, 20, DARKGRAY);
 
-                    if (table.columns->empty()) {
+                    if (game.isWon() and !views.motion.isAnimating()) {
                         gameState = GAME_OVER;
                     }
                 }
 
-                CheckMouseInput(table, hiddenPool, homeCell, cardSize, facecard, backcard);
+                batch.begin(atlas.texture(), CardAtlas::SIZE);
+                {
+                    klondike::ProfileScope timer(PHASE_DRAW_TABLE);
+                    table.drawTable(game, views, cardSize, batch);
+                }
+                {
+                    klondike::ProfileScope timer(PHASE_DRAW_HIDDEN_POOL);
+                    hiddenPool.drawWaste(game, views, batch, cardSize);
+                }
 
-                table.drawTable(cardSize, facecard, backcard, cock, hiddenPool);
-                hiddenPool.drawHiddenPool(facecard, backcard, cardSize);
-                hiddenPool.updateCoords();
-                homeCell.drawHomeCells(cardSize, facecard, backcard, slot);
-                homeCell.updateCoords();
+                {
+                    klondike::ProfileScope timer(PHASE_DRAW_MOVING);
+                    views.drawMoving(cardSize, batch);
+                }
+                if (selectedPile != -1) {
+                    klondike::ProfileScope timer(PHASE_DRAW_DRAGGED);
+                    if (selectedPile == klondike::WASTE) {
+                        views.drawCard(game.top(klondike::WASTE), cardSize,
+                                       batch);
+                    } else {
+                        for (Card card :
+                             game.column(selectedPile).subspan(selectedRow)) {
+                            views.drawCard(card, cardSize, batch);
+                        }
+                    }
+                }
+                {
+                    klondike::ProfileScope timer(PHASE_FLUSH);
+                    batch.end();
+                }
+                DrawHint(game, views, layout);
+
+                if (showStats) {
+                    SpriteBatch::Stats stats = batch.lastFrame();
+                    DrawText(TextFormat("cards: %d draw calls, %d quads",
+                                        stats.drawCalls, stats.quads),
+                             10, 10, 10, DARKGRAY);
+                    klondike::Layout::Stats layoutStats = layout.stats();
+                    DrawText(TextFormat("layout: %llu resizes, %llu pile "
+                                        "refreshes",
+                                        static_cast<unsigned long long>(
+                                            layoutStats.resizes),
+                                        static_cast<unsigned long long>(
+                                            layoutStats.pileRefreshes)),
+                             10, 22, 10, DARKGRAY);
+                    DrawText(klondike::COUNTS_ALLOCATIONS
+                                 ? TextFormat("heap allocations: %llu last "
+                                              "frame",
+                                              static_cast<unsigned long long>(
+                                                  frameAllocations))
+                                 : "heap allocations: debug builds only",
+                             10, 34, 10, DARKGRAY);
+                    DrawText(TextFormat("frames: %llu drawn, %llu skipped, "
+                                        "%llu static repaints",
+                                        static_cast<unsigned long long>(
+                                            framesDrawn),
+                                        static_cast<unsigned long long>(
+                                            framesSkipped),
+                                        static_cast<unsigned long long>(
+                                            layer.repaints())),
+                             10, 46, 10, DARKGRAY);
+                    DrawText(TextFormat("input to screen: p50 %d ms, p99 %d "
+                                        "ms over %llu inputs",
+                                        latency.percentileMs(50),
+                                        latency.percentileMs(99),
+                                        static_cast<unsigned long long>(
+                                            latency.count())),
+                             10, 58, 10, DARKGRAY);
+                    DrawText(TextFormat("textures: %.1f MiB, atlas %dx%d "
+                                        "after %d rebuilds",
+                                        double(TextureBytes(atlas, background,
+                                                            layer)) /
+                                            (1 << 20),
+                                        atlas.texture().width,
+                                        atlas.texture().height,
+                                        atlas.rebuilds()),
+                             10, 70, 10, DARKGRAY);
+                }
 
-                if (selectedCard != nullptr) {
-                    selectedCard->drawCard(cardSize, facecard, backcard);
+                // Everything above should run without touching the heap;
+                // EndDrawing is left out since the GL driver allocates.
+                if (showProfiler) {
+                    DrawProfilerOverlay(GetScreenWidth() - 310, 10);
                 }
 
-                table.refreshPositions(cardSize, hiddenPool);
-                hiddenPool.refreshPositions(cardSize);
+                frameAllocations = allocations.count();
+                if (frameAllocations > 0) {
+                    TraceLog(
+                        LOG_WARNING, "GAME: %llu heap allocations in frame",
+                        static_cast<unsigned long long>(frameAllocations));
+                }
 
-                EndDrawing();
+                {
+                    klondike::ProfileScope timer(PHASE_END_DRAWING);
+                    EndDrawing();
+                }
                 break;
             case GAME_OVER:
                 BeginDrawing();
@@ -389,163 +1030,117 @@ int main() {
                 EndDrawing();
                 break;
         }
+
+        if (unshownInputNs != 0) {
+            const uint64_t shownNs = klondike::Profiler::nowNs();
+            latency.record(shownNs - unshownInputNs);
+            klondike::Profiler::instance().record(PHASE_INPUT_LATENCY,
+                                                  unshownInputNs, shownNs);
+            unshownInputNs = 0;
+        }
+        shown = game;
+        shownState = gameState;
+        if (startNs != 0) {
+            TraceLog(LOG_INFO, "STARTUP: first frame after %.1f ms",
+                     double(klondike::Profiler::nowNs() - startNs) / 1e6);
+            startNs = 0;
+        }
+    }
+
+    TraceLog(LOG_INFO, "FRAMES: %llu drawn, %llu skipped",
+             static_cast<unsigned long long>(framesDrawn),
+             static_cast<unsigned long long>(framesSkipped));
+    if (latency.count() > 0) {
+        TraceLog(LOG_INFO, "LATENCY: %llu inputs, p50 %d ms, p99 %d ms",
+                 static_cast<unsigned long long>(latency.count()),
+                 latency.percentileMs(50), latency.percentileMs(99));
+        for (int ms = 0; ms < LatencyHistogram::BUCKETS; ++ms) {
+            if (latency.buckets()[ms] == 0) continue;
+            TraceLog(LOG_INFO, "LATENCY: %2d ms%s %llu", ms,
+                     ms == LatencyHistogram::BUCKETS - 1 ? "+" : " ",
+                     static_cast<unsigned long long>(latency.buckets()[ms]));
+        }
+    }
+    // A finished game is not picked up again; the next start deals anew.
+    if (saving and game.isWon()) {
+        std::remove(savePath.c_str());
+    } else if (saving and !klondike::saveSnapshot(session, savePath.c_str(),
+                                                  recorder.size())) {
+        TraceLog(LOG_WARNING, "SAVE: cannot write %s", savePath.c_str());
     }
 
-    UnloadTexture(facecard);
-    UnloadTexture(backcard);
-    UnloadTexture(slot);
-    UnloadTexture(cock);
-    UnloadTexture(bg);
+    layer.unload();
+    atlas.unload();
+    background.unload();
 
     CloseWindow();
 
     return 0;
 }
 
-void CheckMouseInput(Table& table, HiddenPool& hiddenPool, HomeCell& homeCell, Vector2 size, Texture2D& facecard, Texture2D& backcard) {
-    Vector2 mousePos = GetMousePosition();
+void HandleMouse(klondike::Game& session, CardViews& views,
+                 HiddenPool& hiddenPool, klondike::Layout& layout,
+                 const InputEvent& event) {
+    const State& game = session.state();
+    Vector2 mousePos = event.position;
+    Vector2 size = ToVector2(layout.cardSize());
 
-    if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
+    if (event.kind == PRESS) {
+        klondike::Hit hit = layout.pick(game, {mousePos.x, mousePos.y});
 
-        Rectangle hiddenPoolRec = {hiddenPool.position.x, hiddenPool.position.y,
-                                   size.x, size.y};
-        if (CheckCollisionPointRec(mousePos, hiddenPoolRec)) {
-            hiddenPool.showNextCard(size);
+        if (hit.pile == klondike::STOCK) {
+            hiddenPool.showNextCard(session, layout);
             return;
         }
 
-        hiddenPoolRec = {hiddenPool.position.x + size.x + 40, hiddenPool.position.y, size.x, size.y};
-
-        if (CheckCollisionPointRec(mousePos, hiddenPoolRec)) {
-            if (!hiddenPool.buffer.empty()) {
-                Card& card = hiddenPool.buffer.back();
-                selectedCard = &card;
-                for (int i = 0; i < hiddenPool.buffer.size(); ++i) {
-                    if (card.value == hiddenPool.buffer[i].value &&
-                        card.suit == hiddenPool.buffer[i].suit) {
-                        selectedRow = i;
-                        break;
-                    }
-                }
+        if (hit.pile == klondike::WASTE) {
+            if (game.wasteSize > 0) {
+                if (CheckDoubleClick(session, layout, hit, event)) return;
+                selectedPile = klondike::WASTE;
+                selectedRow = hit.index;
             }
             return;
         }
 
-        for (int i = 0; i < 7; ++i) {
-            for (int j = table.columns[i].size() - 1; j >= 0; --j) {
-                Card& card = table.columns[i][j];
-                if (card.isFaceUp) {
-                    Rectangle cardRect = {card.position.x, card.position.y,
-                                          size.x, size.y};
-                    if (CheckCollisionPointRec(mousePos, cardRect)) {
-                        selectedCard = &card;
-                        selectedColumn = i;
-                        selectedRow = j;
-                        return;
-                    }
-                }
-            }
+        if (klondike::isTableau(hit.pile) and game.columnSize(hit.pile) > 0 and
+            game.column(hit.pile)[hit.index].isFaceUp()) {
+            if (CheckDoubleClick(session, layout, hit, event)) return;
+            selectedPile = hit.pile;
+            selectedRow = hit.index;
+            return;
         }
     }
 
-    if (IsMouseButtonDown(MOUSE_LEFT_BUTTON) && selectedColumn == -1 && selectedRow != -1) {
-        selectedCard->position.x = mousePos.x - size.x / 2;
-        selectedCard->position.y = mousePos.y - size.y / 2;
-        std::cout << selectedCard->suit << " " << selectedCard->value << '\n';
-    }
-
-    if (IsMouseButtonDown(MOUSE_LEFT_BUTTON) && selectedColumn != -1 && selectedRow != -1) {
-        for (int j = selectedRow; j < table.columns[selectedColumn].size();
-             ++j) {
-            table.columns[selectedColumn][j].position.x =
-                mousePos.x - size.x / 2;
-            table.columns[selectedColumn][j].position.y =
-                mousePos.y + (j - selectedRow) * 30 - size.y / 2;
+    if (selectedPile == -1) return;
+
+    Move move = {
+        static_cast<uint8_t>(selectedPile), 0,
+        static_cast<uint8_t>(game.pileSize(selectedPile) - selectedRow)};
+
+    if (event.kind == DRAG) {
+        for (int j = 0; j < move.count; ++j) {
+            Card card = selectedPile == klondike::WASTE
+                            ? game.top(klondike::WASTE)
+                            : game.column(selectedPile)[selectedRow + j];
+            views.place(card, {mousePos.x - size.x / 2,
+                               mousePos.y +
+                                   float(j) * klondike::Layout::FAN_OFFSET -
+                                   size.y / 2});
         }
     }
 
-    if (IsMouseButtonReleased(MOUSE_LEFT_BUTTON) && selectedCard != nullptr) {
-        bool cardMoved = false;
-
-        for (int i = 0; i < 7; ++i) {
-            if (i != selectedColumn) {
-                if (!table.columns[i].empty()) {
-                    Card& targetCard = table.columns[i].back();
-                    Rectangle targetRect = {targetCard.position.x,
-                                            targetCard.position.y, size.x,
-                                            size.y};
-
-                    if (CheckCollisionPointRec(mousePos, targetRect)) {
-                        if (targetCard.value - selectedCard->value != 1 or !selectedCard->suitReliable(targetCard)) {
-                            continue;
-                        }
-                        if (selectedColumn != -1) {
-                            table.moveCards(selectedColumn, selectedRow, i);
-                            if (selectedRow > 0) {
-                                table.columns[selectedColumn][selectedRow - 1].isFaceUp =
-                                    true;
-                            }
-                        } else {
-                            table.moveFromHiddenPool(hiddenPool, i);
-                        }
-                        cardMoved = true;
-                        break;
-                    }
-                } else {
-                    Rectangle emptyRect = {float(100 + i * (size.x + 10)),
-                                           200.0f, size.x, size.y};
-
-                    if (CheckCollisionPointRec(mousePos, emptyRect)) {
-                        if (selectedCard->value == 13) {
-                            if (selectedColumn != -1) {
-                            table.moveCards(selectedColumn, selectedRow, i);
-                                if (selectedRow > 0) {
-                                    table
-                                        .columns[selectedColumn]
-                                                [selectedRow - 1]
-                                        .faceToggle();
-                                }
-                            } else {
-                                table.moveFromHiddenPool(hiddenPool, i);
-                            }
-                            cardMoved = true;
-                            break;
-                        }
-                    }
-                }
-            }
-        }
-
-        if (!cardMoved) {
-            for (int i = 0; i < 4; ++i) {
-                Rectangle homeCellRect = {
-                    homeCell.position.x + i * (size.x + 20),
-                    homeCell.position.y, size.x, size.y};
-                if (CheckCollisionPointRec(mousePos, homeCellRect)) {
-                    if (homeCell.canPlaceCard(*selectedCard)) {
-                        homeCell.placeCard(*selectedCard, size);
-                        if (selectedColumn != -1) {
-                            table.columns[selectedColumn].erase(
-                                table.columns[selectedColumn].begin() +
-                                    selectedRow,
-                                table.columns[selectedColumn].end());
-                            if (!table.columns[selectedColumn][selectedRow - 1]
-                                     .isFaceUp) {
-                                table.columns[selectedColumn][selectedRow - 1]
-                                    .faceToggle();
-                            }
-                        } else {
-                            hiddenPool.buffer.pop_back();
-                        }
-                        cardMoved = true;
-                        break;
-                    }
-                }
-            }
+    if (event.kind == RELEASE) {
+        // The same lookup as for picking up: any part of a column or home
+        // cell counts as dropping onto it.
+        klondike::Hit hit = layout.pick(game, {mousePos.x, mousePos.y});
+        move.to = static_cast<uint8_t>(hit.pile);
+        if (hit.pile != -1 and game.isLegal(move)) {
+            PlayMove(session, layout, move);
+        } else {
+            // Dragged cards that did not land go back where they came from.
+            layout.markDirty(selectedPile);
         }
-
-        selectedCard = nullptr;
-        selectedColumn = -1;
+        selectedPile = -1;
         selectedRow = -1;
     }
 }
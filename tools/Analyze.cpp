@@ -0,0 +1,158 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "Args.hpp"
+#include "Commands.hpp"
+#include "Klondike.hpp"
+#include "Solver.hpp"
+#include "ThreadPool.hpp"
+
+using namespace klondike;
+
+namespace {
+
+struct DealResult {
+    uint64_t seed;
+    Verdict verdict;
+    uint16_t moves;
+    uint64_t nodes;
+    uint32_t micros;
+};
+
+// At most this many deals are queued or waiting to be written, so results
+// come out in seed order with bounded memory.
+constexpr uint64_t WINDOW = 1 << 16;
+
+// Where a deal's result waits until every deal before it is written.
+struct Slot {
+    DealResult result;
+    std::atomic<bool> done{false};
+};
+
+// Binary records are little-endian, 23 bytes each, after a "KDA1" magic:
+// u64 seed, u8 verdict, u16 solution length, u64 nodes, u32 microseconds.
+void WriteLittleEndian(std::FILE* out, uint64_t value, int bytes) {
+    unsigned char buffer[8];
+    for (int i = 0; i < bytes; ++i) {
+        buffer[i] = static_cast<unsigned char>(value >> (8 * i));
+    }
+    std::fwrite(buffer, 1, std::size_t(bytes), out);
+}
+
+void WriteResult(std::FILE* out, const DealResult& result, bool binary) {
+    if (binary) {
+        WriteLittleEndian(out, result.seed, 8);
+        WriteLittleEndian(out, uint64_t(result.verdict), 1);
+        WriteLittleEndian(out, result.moves, 2);
+        WriteLittleEndian(out, result.nodes, 8);
+        WriteLittleEndian(out, result.micros, 4);
+    } else {
+        static const char* verdicts[] = {"won", "lost", "unknown"};
+        std::fprintf(out, "%llu,%s,%u,%llu,%u\n",
+                     static_cast<unsigned long long>(result.seed),
+                     verdicts[result.verdict], unsigned(result.moves),
+                     static_cast<unsigned long long>(result.nodes),
+                     unsigned(result.micros));
+    }
+}
+
+}  // namespace
+
+int RunAnalyze(int argc, char** argv) {
+    Args args(argc, argv);
+    const uint64_t from = args.number("from", 0);
+    const uint64_t count = args.number("count", 1000);
+    const bool binary = args.get("format", "csv") == "binary";
+    const std::string outPath = args.get("out");
+
+    SolverLimits limits;
+    limits.maxNodes = args.number("nodes", 1'000'000);
+    limits.memoryBytes = std::size_t(args.number("memory", 32)) << 20;
+    if (limits.memoryBytes == 0) {
+        std::fprintf(stderr, "--memory must be at least 1 MB\n");
+        return 2;
+    }
+
+    std::FILE* out = outPath.empty() ? stdout
+                                     : std::fopen(outPath.c_str(), "wb");
+    if (!out) {
+        std::perror(outPath.c_str());
+        return 1;
+    }
+
+    ThreadPool pool(
+        unsigned(args.number("threads", std::thread::hardware_concurrency())));
+    std::vector<std::unique_ptr<Solver>> solvers;
+    for (unsigned i = 0; i < pool.size(); ++i) {
+        solvers.push_back(std::make_unique<Solver>(limits));
+    }
+
+    if (binary) {
+        std::fwrite("KDA1", 1, 4, out);
+    } else {
+        std::fprintf(out, "seed,result,moves,nodes,micros\n");
+    }
+
+    uint64_t totals[3] = {};
+    uint64_t totalNodes = 0;
+    const auto begin = std::chrono::steady_clock::now();
+    // A ring of WINDOW slots, refilled one deal per result written, so
+    // the workers never wait for the slowest deal of a batch. Each task
+    // solves whichever deal is next rather than one picked when it was
+    // queued: the pool runs its own tasks newest first, and this way the
+    // deal the writer waits for is always the first one started.
+    const std::unique_ptr<Slot[]> slots(new Slot[WINDOW]);
+    std::atomic<uint64_t> claimed{0};
+    auto solveNext = [&] {
+        const uint64_t index = claimed.fetch_add(1, std::memory_order_relaxed);
+        Slot& slot = slots[index % WINDOW];
+        DealResult& result = slot.result;
+        result.seed = from + index;
+        State state = dealFromSeed(result.seed);
+        Solution solution = solvers[ThreadPool::currentWorker()]->solve(state);
+        result.verdict = solution.verdict;
+        result.moves = static_cast<uint16_t>(solution.moves.size());
+        result.nodes = solution.stats.nodes;
+        result.micros = static_cast<uint32_t>(solution.stats.seconds * 1e6);
+        slot.done.store(true, std::memory_order_release);
+        slot.done.notify_one();
+    };
+
+    for (uint64_t i = 0; i < std::min(WINDOW, count); ++i) {
+        pool.submit(solveNext);
+    }
+    for (uint64_t next = 0; next < count; ++next) {
+        Slot& slot = slots[next % WINDOW];
+        slot.done.wait(false, std::memory_order_acquire);
+        const DealResult result = slot.result;
+        slot.done.store(false, std::memory_order_relaxed);
+        // Only claimed once this slot is free again.
+        if (next + WINDOW < count) pool.submit(solveNext);
+
+        WriteResult(out, result, binary);
+        ++totals[result.verdict];
+        totalNodes += result.nodes;
+    }
+    // The last tasks may still be returning from notify_one().
+    pool.wait();
+
+    const double seconds = std::chrono::duration<double>(
+                               std::chrono::steady_clock::now() - begin)
+                               .count();
+    std::fprintf(stderr,
+                 "%llu deals on %u threads in %.2fs: %llu won, %llu lost, "
+                 "%llu undecided (%.1f%% won), %.2f Mnodes/s\n",
+                 static_cast<unsigned long long>(count), pool.size(), seconds,
+                 static_cast<unsigned long long>(totals[SOLVED]),
+                 static_cast<unsigned long long>(totals[UNSOLVABLE]),
+                 static_cast<unsigned long long>(totals[GAVE_UP]),
+                 count ? 100.0 * double(totals[SOLVED]) / double(count) : 0.0,
+                 seconds > 0 ? double(totalNodes) / seconds / 1e6 : 0.0);
+
+    if (out != stdout) std::fclose(out);
+    return 0;
+}
@@ -0,0 +1,126 @@
+#include <cstdio>
+#include <cstring>
+#include "Args.hpp"
+#include "Commands.hpp"
+#include "Game.hpp"
+#include "Snapshot.hpp"
+
+using namespace klondike;
+
+namespace {
+
+// Recomputes the checksum after `bytes` have been tampered with, as anyone
+// forging a snapshot would.
+void Reseal(SnapshotBuffer& bytes, std::size_t size) {
+    uint32_t hash = 2166136261u;
+    for (std::size_t i = 0; i + 4 < size; ++i) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    for (int i = 0; i < 4; ++i) {
+        bytes[size - 4 + std::size_t(i)] = static_cast<uint8_t>(hash >> 8 * i);
+    }
+}
+
+// `forged` with `state` in place of the snapshot's own, resealed.
+bool DecodesWithState(SnapshotBuffer forged, std::size_t size,
+                      const State& state) {
+    std::memcpy(&forged[SNAPSHOT_HEADER_SIZE - sizeof(State)], &state,
+                sizeof(State));
+    Reseal(forged, size);
+    Game restored;
+    return decodeSnapshot({forged.data(), size}, restored);
+}
+
+// Snapshots arrive from disk and from server clients, so decoding must turn
+// away forgeries that pass the checksum. Prints and returns false if one
+// gets through.
+bool CheckSnapshotForgeries() {
+    Game game;
+    game.deal(1);
+    for (int i = 0; i < 40; ++i) {
+        Move move;
+        if (!game.hint(move)) break;
+        game.play(move);
+    }
+    SnapshotBuffer genuine;
+    const std::size_t size = encodeSnapshot(game, genuine);
+    const int applied = game.history().size();
+    Game restored;
+    if (applied == 0 or !decodeSnapshot({genuine.data(), size}, restored)) {
+        std::printf("snapshot: a real game does not decode\n");
+        return false;
+    }
+
+    // The last move undone would be taken from a pile that does not exist,
+    // or put back more cards than its target holds.
+    const Move forgedMoves[] = {{15, TABLEAU, 1}, {TABLEAU, TABLEAU + 1, 20}};
+    for (Move move : forgedMoves) {
+        SnapshotBuffer forged = genuine;
+        const std::size_t last = SNAPSHOT_HEADER_SIZE + 2 * (applied - 1);
+        const PackedMove packed = PackedMove::pack({move, false});
+        forged[last] = static_cast<uint8_t>(packed.bits);
+        forged[last + 1] = static_cast<uint8_t>(packed.bits >> 8);
+        Reseal(forged, size);
+        if (decodeSnapshot({forged.data(), size}, restored)) {
+            std::printf("snapshot: forged history %d->%d x%d decodes\n",
+                        move.from, move.to, move.count);
+            return false;
+        }
+    }
+
+    // Positions with every card accounted for that play cannot reach.
+    Game fresh;
+    fresh.deal(1);
+    SnapshotBuffer blank;
+    const std::size_t freshSize = encodeSnapshot(fresh, blank);
+    const State dealt = fresh.state();
+
+    // Twenty cards in one column, one more than a game can build.
+    State tall = {};
+    const Deck deck = orderedDeck();
+    for (int i = 0; i < DECK_SIZE - 8; ++i) tall.cards[i] = deck[8 + i];
+    for (auto& end : tall.columnEnd) end = 20;
+    tall.talonSize = TALON_SIZE;
+    tall.foundation[HEARTS] = 8;
+
+    State buried = dealt;  // a face-down card on top of column 6
+    buried.cards[buried.columnEnd[6] - 1] =
+        buried.cards[buried.columnEnd[6] - 1].faceDown();
+    State unstacked = dealt;  // a face-up card under the top of column 6
+    unstacked.cards[unstacked.columnEnd[6] - 2] =
+        unstacked.cards[unstacked.columnEnd[6] - 2].faceUp();
+    State shown = dealt;  // a face-up card in the stock
+    shown.cards[shown.talonBegin()] = shown.cards[shown.talonBegin()].faceUp();
+
+    const struct {
+        const char* name;
+        const State& state;
+    } forgedStates[] = {{"a 20-card column", tall},
+                        {"a face-down top card", buried},
+                        {"a face-up run out of sequence", unstacked},
+                        {"a face-up stock card", shown}};
+    if (!DecodesWithState(blank, freshSize, dealt)) {
+        std::printf("snapshot: a fresh deal does not decode\n");
+        return false;
+    }
+    for (const auto& forged : forgedStates) {
+        if (DecodesWithState(blank, freshSize, forged.state)) {
+            std::printf("snapshot: %s decodes\n", forged.name);
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+int RunCheck(int argc, char** argv) {
+    Args args(argc, argv);
+    if (!args.positional().empty()) {
+        std::fprintf(stderr, "check: takes no arguments\n");
+        return 2;
+    }
+    const bool passed = CheckSnapshotForgeries();
+    std::printf(passed ? "all checks passed\n" : "check failed\n");
+    return passed ? 0 : 1;
+}
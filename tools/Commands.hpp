@@ -0,0 +1,9 @@
+#pragma once
+
+// Subcommands of klonkdike_cli. Each gets the arguments after its name.
+int RunAnalyze(int argc, char** argv);
+int RunCheck(int argc, char** argv);
+int RunDeals(int argc, char** argv);
+int RunReplay(int argc, char** argv);
+int RunServe(int argc, char** argv);
+int RunSimulate(int argc, char** argv);
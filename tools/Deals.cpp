@@ -0,0 +1,123 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "Args.hpp"
+#include "Commands.hpp"
+#include "DealDb.hpp"
+#include "MappedFile.hpp"
+
+using namespace klondike;
+
+namespace {
+
+// What `analyze --format binary` writes: "KDA1", then per deal a u64
+// seed, u8 verdict, u16 solution length, u64 nodes and u32 microseconds.
+constexpr std::size_t ANALYSIS_RECORD_SIZE = 23;
+
+uint64_t GetLittleEndian(const uint8_t* in, int bytes) {
+    uint64_t value = 0;
+    for (int i = bytes - 1; i >= 0; --i) value = value << 8 | in[i];
+    return value;
+}
+
+bool ReadAnalysis(const char* path, std::vector<DealRecord>& deals) {
+    MappedFile file;
+    if (!file.open(path)) return false;
+    std::span<const uint8_t> bytes = file.bytes();
+    if (bytes.size() < 4 or std::memcmp(bytes.data(), "KDA1", 4) != 0 or
+        (bytes.size() - 4) % ANALYSIS_RECORD_SIZE != 0) {
+        return false;
+    }
+    for (std::size_t at = 4; at < bytes.size(); at += ANALYSIS_RECORD_SIZE) {
+        const uint8_t* in = &bytes[at];
+        if (in[8] > GAVE_UP) return false;
+        const uint64_t nodes = GetLittleEndian(in + 11, 8);
+        deals.push_back({GetLittleEndian(in, 8),
+                         uint32_t(std::min<uint64_t>(nodes, UINT32_MAX)),
+                         uint16_t(GetLittleEndian(in + 9, 2)), Verdict(in[8]),
+                         0});
+    }
+    return true;
+}
+
+}  // namespace
+
+int RunDeals(int argc, char** argv) {
+    Args args(argc, argv);
+    if (args.positional().empty()) {
+        std::fprintf(stderr, "deals: no analysis files given\n");
+        return 2;
+    }
+    const int buckets = int(args.number("buckets", 5));
+    if (buckets < 1 or buckets > DEAL_DB_MAX_BUCKETS) {
+        std::fprintf(stderr, "--buckets must be 1 to %d\n",
+                     DEAL_DB_MAX_BUCKETS);
+        return 2;
+    }
+    const std::string outPath = args.get("out", "deals.kdd");
+
+    std::vector<DealRecord> deals;
+    for (const std::string& path : args.positional()) {
+        if (!ReadAnalysis(path.c_str(), deals)) {
+            std::fprintf(stderr, "%s: not a binary analysis\n", path.c_str());
+            return 1;
+        }
+    }
+    // A seed analysed twice keeps its first result.
+    std::stable_sort(deals.begin(), deals.end(),
+                     [](const DealRecord& a, const DealRecord& b) {
+                         return a.seed < b.seed;
+                     });
+    deals.erase(std::unique(deals.begin(), deals.end(),
+                            [](const DealRecord& a, const DealRecord& b) {
+                                return a.seed == b.seed;
+                            }),
+                deals.end());
+    if (deals.size() > UINT32_MAX) {
+        std::fprintf(stderr, "deals: too many deals for one file\n");
+        return 1;
+    }
+
+    const std::vector<uint8_t> bytes = buildDealDb(std::move(deals), buckets);
+    std::FILE* out = std::fopen(outPath.c_str(), "wb");
+    if (!out) {
+        std::perror(outPath.c_str());
+        return 1;
+    }
+    const bool written =
+        std::fwrite(bytes.data(), 1, bytes.size(), out) == bytes.size();
+    if (std::fclose(out) != 0 or !written) {
+        std::perror(outPath.c_str());
+        return 1;
+    }
+
+    DealDb db;
+    db.attach(bytes);
+    std::fprintf(stderr, "%s: %u deals, %u unwinnable, %u undecided\n",
+                 outPath.c_str(), db.size(), db.count(db.unwinnableGroup()),
+                 db.count(db.undecidedGroup()));
+    for (int bucket = 0; bucket < db.buckets(); ++bucket) {
+        const uint32_t count = db.count(bucket);
+        if (count == 0) {
+            std::fprintf(stderr, "  difficulty %d: none\n", bucket);
+            continue;
+        }
+        uint32_t minNodes = UINT32_MAX;
+        uint32_t maxNodes = 0;
+        uint64_t moves = 0;
+        for (uint32_t i = 0; i < count; ++i) {
+            const DealRecord record = db.record(bucket, i);
+            minNodes = std::min(minNodes, record.nodes);
+            maxNodes = std::max(maxNodes, record.nodes);
+            moves += record.moves;
+        }
+        std::fprintf(stderr,
+                     "  difficulty %d: %u winnable, %u-%u nodes, %.0f moves "
+                     "on average\n",
+                     bucket, count, minNodes, maxNodes,
+                     double(moves) / count);
+    }
+    return 0;
+}
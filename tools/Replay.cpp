@@ -0,0 +1,110 @@
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "Args.hpp"
+#include "Commands.hpp"
+#include "Game.hpp"
+#include "MappedFile.hpp"
+#include "Replay.hpp"
+
+using namespace klondike;
+
+namespace {
+
+struct ReplayTotals {
+    uint64_t files = 0;
+    uint64_t games = 0;
+    uint64_t events = 0;
+    uint64_t won = 0;
+    uint64_t failed = 0;
+};
+
+// Plays every game in one file as fast as possible. A game stops at the
+// first event that does not fit its position.
+void ReplayFile(const std::string& path, Game& game, ReplayTotals& totals) {
+    MappedFile file;
+    if (!file.open(path.c_str())) {
+        std::printf("%s: cannot open\n", path.c_str());
+        ++totals.failed;
+        return;
+    }
+    ++totals.files;
+
+    ReplayReader reader(file.bytes());
+    uint64_t seed;
+    Variant variant;
+    for (uint64_t index = 0; reader.nextGame(seed, variant); ++index) {
+        ++totals.games;
+        game.deal(seed, variant);
+        ReplayEvent event;
+        Move changed;
+        for (uint64_t count = 0; reader.next(event); ++count) {
+            ++totals.events;
+            if (!game.play(event, changed)) {
+                std::printf("%s: game %llu (seed %llu): event %llu does not "
+                            "fit the position\n",
+                            path.c_str(),
+                            static_cast<unsigned long long>(index),
+                            static_cast<unsigned long long>(seed),
+                            static_cast<unsigned long long>(count));
+                ++totals.failed;
+                break;
+            }
+        }
+        if (game.state().isWon()) ++totals.won;
+    }
+    if (reader.corrupt()) {
+        std::printf("%s: damaged after %llu games\n", path.c_str(),
+                    static_cast<unsigned long long>(totals.games));
+        ++totals.failed;
+    }
+}
+
+}  // namespace
+
+int RunReplay(int argc, char** argv) {
+    Args args(argc, argv);
+    if (args.positional().empty()) {
+        std::fprintf(stderr, "replay: no files or directories given\n");
+        return 2;
+    }
+
+    // Directories are searched for .kdr files; only paths are kept, the
+    // files themselves are mapped one at a time.
+    std::vector<std::string> paths;
+    for (const std::string& arg : args.positional()) {
+        std::error_code error;
+        if (!std::filesystem::is_directory(arg, error)) {
+            paths.push_back(arg);
+            continue;
+        }
+        for (const auto& entry :
+             std::filesystem::recursive_directory_iterator(arg, error)) {
+            if (entry.is_regular_file() and
+                entry.path().extension() == ".kdr") {
+                paths.push_back(entry.path().string());
+            }
+        }
+    }
+
+    Game game;
+    ReplayTotals totals;
+    const auto begin = std::chrono::steady_clock::now();
+    for (const std::string& path : paths) ReplayFile(path, game, totals);
+    const double seconds = std::chrono::duration<double>(
+                               std::chrono::steady_clock::now() - begin)
+                               .count();
+
+    std::fprintf(stderr,
+                 "%llu games (%llu won) and %llu events from %llu files in "
+                 "%.2fs, %.0f games/s; %llu failed\n",
+                 static_cast<unsigned long long>(totals.games),
+                 static_cast<unsigned long long>(totals.won),
+                 static_cast<unsigned long long>(totals.events),
+                 static_cast<unsigned long long>(totals.files), seconds,
+                 seconds > 0 ? double(totals.games) / seconds : 0.0,
+                 static_cast<unsigned long long>(totals.failed));
+    return totals.failed ? 1 : 0;
+}
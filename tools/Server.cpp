@@ -0,0 +1,421 @@
+#include <cstdio>
+#include <string>
+#include "Args.hpp"
+#include "Commands.hpp"
+
+#ifdef __linux__
+
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <csignal>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "Game.hpp"
+#include "Snapshot.hpp"
+
+using namespace klondike;
+
+namespace {
+
+// Line protocol, one request per line, one reply line each:
+//
+//   new SEED [VARIANT]    ok SEED VARIANT
+//   moves                 ok N FROM:TO:COUNT ...
+//   move FROM TO COUNT    ok playing|won
+//   undo, redo            ok FROM:TO:COUNT (the move taken back or replayed)
+//   hint                  ok FROM:TO:COUNT
+//   state                 ok HEX playing|won SCORE (HEX: the 72-byte State)
+//   snapshot              ok HEX (HEX: the game as in Snapshot.hpp)
+//   restore HEX           ok playing|won
+//   quit                  closes the connection once earlier replies are
+//                         sent; so does the client closing its end
+//
+// Piles are numbered as in Klondike.hpp. Failures reply "err MESSAGE".
+// The longest request is a restore with a full undo log.
+constexpr std::size_t MAX_LINE = 16 + 2 * SNAPSHOT_MAX_SIZE;
+// A client that sends without reading is dropped past this much backlog.
+constexpr std::size_t MAX_PENDING_OUTPUT = std::size_t(1) << 20;
+constexpr int MAX_EVENTS = 64;
+
+std::atomic<bool> stopping{false};
+
+void Stop(int) { stopping = true; }
+
+struct Session {
+    int fd;
+    Game game;
+    bool dealt = false;
+    uint32_t interest = EPOLLIN | EPOLLRDHUP;  // as registered with epoll
+    // Sent quit or closed its end: nothing more is read, and the session
+    // goes once its output is out.
+    bool closing = false;
+    std::string input;
+    std::string output;
+};
+
+std::vector<std::string_view> Split(std::string_view line) {
+    std::vector<std::string_view> words;
+    while (!line.empty()) {
+        const std::size_t start = line.find_first_not_of(' ');
+        if (start == std::string_view::npos) break;
+        line.remove_prefix(start);
+        const std::size_t end = std::min(line.find(' '), line.size());
+        words.push_back(line.substr(0, end));
+        line.remove_prefix(end);
+    }
+    return words;
+}
+
+template <class T>
+bool ParseNumber(std::string_view word, T& value) {
+    const auto [end, error] =
+        std::from_chars(word.data(), word.data() + word.size(), value);
+    return error == std::errc() and end == word.data() + word.size();
+}
+
+void AppendMove(std::string& out, Move move) {
+    out += ' ';
+    out += std::to_string(move.from) + ':' + std::to_string(move.to) + ':' +
+           std::to_string(move.count);
+}
+
+void AppendHex(std::string& out, const uint8_t* bytes, std::size_t size) {
+    static const char digits[] = "0123456789abcdef";
+    for (std::size_t i = 0; i < size; ++i) {
+        out += digits[bytes[i] >> 4];
+        out += digits[bytes[i] & 0xF];
+    }
+}
+
+// False unless `hex` is an even number of hex digits that fit `bytes`.
+bool ParseHex(std::string_view hex, SnapshotBuffer& bytes, std::size_t& size) {
+    if (hex.size() % 2 != 0 or hex.size() / 2 > bytes.size()) return false;
+    size = hex.size() / 2;
+    for (std::size_t i = 0; i < size; ++i) {
+        const auto [end, error] = std::from_chars(
+            hex.data() + 2 * i, hex.data() + 2 * i + 2, bytes[i], 16);
+        if (error != std::errc() or end != hex.data() + 2 * i + 2) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void Handle(Session& session, std::string_view line) {
+    std::string& out = session.output;
+    const std::vector<std::string_view> words = Split(line);
+    if (words.empty()) {
+        out += "err empty request\n";
+        return;
+    }
+    const std::string_view command = words[0];
+    Game& game = session.game;
+
+    if (command == "new") {
+        uint64_t seed = 0;
+        Variant variant = STANDARD;
+        if (words.size() < 2 or !ParseNumber(words[1], seed) or
+            (words.size() > 2 and !parseVariant(words[2], variant))) {
+            out += "err usage: new SEED [standard|draw3|vegas|vegas3]\n";
+            return;
+        }
+        game.deal(seed, variant);
+        session.dealt = true;
+        out += "ok " + std::to_string(seed) + ' ' +
+               std::string(VARIANT_NAMES[variant]) + '\n';
+        return;
+    }
+    if (command == "restore") {
+        SnapshotBuffer bytes;
+        std::size_t size = 0;
+        if (words.size() != 2 or !ParseHex(words[1], bytes, size) or
+            !decodeSnapshot({bytes.data(), size}, game)) {
+            out += "err usage: restore SNAPSHOT\n";
+            return;
+        }
+        session.dealt = true;
+        out += game.state().isWon() ? "ok won\n" : "ok playing\n";
+        return;
+    }
+    if (!session.dealt) {
+        out += "err no game, send: new SEED\n";
+        return;
+    }
+
+    Move move = {};
+    if (command == "moves") {
+        MoveList moves;
+        game.legalMoves().list(moves);
+        out += "ok " + std::to_string(moves.size());
+        for (Move legal : moves) AppendMove(out, legal);
+        out += '\n';
+    } else if (command == "move") {
+        if (words.size() != 4 or !ParseNumber(words[1], move.from) or
+            !ParseNumber(words[2], move.to) or
+            !ParseNumber(words[3], move.count)) {
+            out += "err usage: move FROM TO COUNT\n";
+        } else if (!game.play(move)) {
+            out += "err illegal move\n";
+        } else {
+            out += game.state().isWon() ? "ok won\n" : "ok playing\n";
+        }
+    } else if (command == "undo" or command == "redo") {
+        const bool done =
+            command == "undo" ? game.undo(move) : game.redo(move);
+        if (!done) {
+            out += "err nothing to " + std::string(command) + '\n';
+        } else {
+            out += "ok";
+            AppendMove(out, move);
+            out += '\n';
+        }
+    } else if (command == "hint") {
+        if (!game.hint(move)) {
+            out += "err no useful move\n";
+        } else {
+            out += "ok";
+            AppendMove(out, move);
+            out += '\n';
+        }
+    } else if (command == "state") {
+        out += "ok ";
+        AppendHex(out, reinterpret_cast<const uint8_t*>(&game.state()),
+                  sizeof(State));
+        out += game.state().isWon() ? " won " : " playing ";
+        out += std::to_string(game.state().score) + '\n';
+    } else if (command == "snapshot") {
+        SnapshotBuffer bytes;
+        const std::size_t size = encodeSnapshot(game, bytes);
+        out += "ok ";
+        AppendHex(out, bytes.data(), size);
+        out += '\n';
+    } else {
+        out += "err unknown command\n";
+    }
+}
+
+// One per thread. Every loop waits on the shared listening socket with
+// EPOLLEXCLUSIVE, so a new connection wakes one loop, and that loop owns
+// the connection's session for its whole life: nothing is shared between
+// loops and nothing is locked.
+class EventLoop {
+   public:
+    explicit EventLoop(int listener) : listener_(listener) {}
+    ~EventLoop() {
+        for (auto& [fd, session] : sessions_) ::close(fd);
+        if (epoll_ >= 0) ::close(epoll_);
+    }
+
+    bool open() {
+        epoll_ = epoll_create1(EPOLL_CLOEXEC);
+        if (epoll_ < 0) return false;
+        epoll_event event = {};
+        event.events = EPOLLIN | EPOLLEXCLUSIVE;
+        event.data.fd = listener_;
+        return epoll_ctl(epoll_, EPOLL_CTL_ADD, listener_, &event) == 0;
+    }
+
+    // Runs until `stopping` is set.
+    void run() {
+        epoll_event events[MAX_EVENTS];
+        while (!stopping) {
+            // The timeout is only there to notice `stopping`.
+            const int count = epoll_wait(epoll_, events, MAX_EVENTS, 250);
+            for (int i = 0; i < count; ++i) {
+                if (events[i].data.fd == listener_) {
+                    acceptAll();
+                } else {
+                    serve(events[i].data.fd, events[i].events);
+                }
+            }
+        }
+    }
+
+   private:
+    void acceptAll() {
+        for (;;) {
+            const int fd =
+                accept4(listener_, nullptr, nullptr,
+                        SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) return;  // EAGAIN: another loop got it, or done
+            epoll_event event = {};
+            event.events = EPOLLIN | EPOLLRDHUP;
+            event.data.fd = fd;
+            if (epoll_ctl(epoll_, EPOLL_CTL_ADD, fd, &event) != 0) {
+                ::close(fd);
+                continue;
+            }
+            auto session = std::make_unique<Session>();
+            session->fd = fd;
+            sessions_[fd] = std::move(session);
+        }
+    }
+
+    void serve(int fd, uint32_t events) {
+        auto found = sessions_.find(fd);
+        if (found == sessions_.end()) return;
+        Session& session = *found->second;
+
+        bool open = (events & (EPOLLERR | EPOLLHUP)) == 0;
+        if (open and !session.closing and (events & (EPOLLIN | EPOLLRDHUP))) {
+            open = receive(session);
+        }
+        if (open) open = flush(session);
+        if (open and session.closing and session.output.empty()) open = false;
+        if (!open) {
+            epoll_ctl(epoll_, EPOLL_CTL_DEL, fd, nullptr);
+            ::close(fd);
+            sessions_.erase(found);
+        }
+    }
+
+    // Reads what is there and answers every complete line, up to a quit or
+    // the end of the input, which mark the session closing. False if it
+    // has to go straight away: the connection failed or the peer sent
+    // garbage.
+    bool receive(Session& session) {
+        char buffer[4096];
+        for (;;) {
+            const ssize_t size = ::recv(session.fd, buffer, sizeof buffer, 0);
+            if (size == 0) {
+                session.closing = true;
+                return true;
+            }
+            if (size < 0) {
+                return errno == EAGAIN or errno == EWOULDBLOCK or
+                       errno == EINTR;
+            }
+            session.input.append(buffer, std::size_t(size));
+
+            std::size_t start = 0;
+            for (std::size_t end;
+                 (end = session.input.find('\n', start)) != std::string::npos;
+                 start = end + 1) {
+                std::string_view line(session.input.data() + start,
+                                      end - start);
+                if (!line.empty() and line.back() == '\r') {
+                    line.remove_suffix(1);
+                }
+                if (line == "quit") {
+                    session.closing = true;
+                    return true;
+                }
+                Handle(session, line);
+            }
+            session.input.erase(0, start);
+            if (session.input.size() > MAX_LINE or
+                session.output.size() > MAX_PENDING_OUTPUT) {
+                return false;
+            }
+        }
+    }
+
+    // Writes as much of the pending output as the socket takes, and asks
+    // for EPOLLOUT only while some is left, so the usual request costs no
+    // epoll_ctl. A closing session stops asking for input, which would
+    // otherwise keep firing for a peer that has shut its end.
+    bool flush(Session& session) {
+        std::size_t sent = 0;
+        while (sent < session.output.size()) {
+            const ssize_t size =
+                ::send(session.fd, session.output.data() + sent,
+                       session.output.size() - sent, MSG_NOSIGNAL);
+            if (size < 0) {
+                if (errno == EINTR) continue;
+                if (errno != EAGAIN and errno != EWOULDBLOCK) return false;
+                break;
+            }
+            sent += std::size_t(size);
+        }
+        session.output.erase(0, sent);
+
+        const uint32_t interest =
+            (session.closing ? 0u : EPOLLIN | EPOLLRDHUP) |
+            (session.output.empty() ? 0u : EPOLLOUT);
+        if (interest == session.interest) return true;
+        session.interest = interest;
+        epoll_event event = {};
+        event.events = interest;
+        event.data.fd = session.fd;
+        return epoll_ctl(epoll_, EPOLL_CTL_MOD, session.fd, &event) == 0;
+    }
+
+    int listener_;
+    int epoll_ = -1;
+    std::unordered_map<int, std::unique_ptr<Session>> sessions_;
+};
+
+}  // namespace
+
+int RunServe(int argc, char** argv) {
+    Args args(argc, argv);
+    const std::string path = args.get("socket", "klonkdike.sock");
+    const unsigned threads =
+        unsigned(args.number("threads", std::thread::hardware_concurrency()));
+
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof address.sun_path) {
+        std::fprintf(stderr, "serve: socket path too long\n");
+        return 2;
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    const int listener =
+        socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    ::unlink(path.c_str());  // left over from a server that did not exit
+    if (listener < 0 or
+        bind(listener, reinterpret_cast<sockaddr*>(&address),
+             sizeof address) != 0 or
+        listen(listener, SOMAXCONN) != 0) {
+        std::perror(path.c_str());
+        if (listener >= 0) ::close(listener);
+        return 1;
+    }
+
+    std::signal(SIGINT, Stop);
+    std::signal(SIGTERM, Stop);
+
+    std::vector<std::unique_ptr<EventLoop>> loops;
+    for (unsigned i = 0; i < std::max(threads, 1u); ++i) {
+        loops.push_back(std::make_unique<EventLoop>(listener));
+        if (!loops.back()->open()) {
+            std::perror("epoll");
+            ::close(listener);
+            ::unlink(path.c_str());
+            return 1;
+        }
+    }
+    std::fprintf(stderr, "serving on %s with %zu loops\n", path.c_str(),
+                 loops.size());
+
+    std::vector<std::thread> workers;
+    for (auto& loop : loops) {
+        workers.emplace_back([&loop] { loop->run(); });
+    }
+    for (std::thread& worker : workers) worker.join();
+
+    loops.clear();
+    ::close(listener);
+    ::unlink(path.c_str());
+    return 0;
+}
+
+#else
+
+int RunServe(int, char**) {
+    std::fprintf(stderr, "serve: only available on Linux\n");
+    return 1;
+}
+
+#endif
@@ -0,0 +1,95 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Args.hpp"
+#include "Batch.hpp"
+#include "Commands.hpp"
+#include "ThreadPool.hpp"
+
+using namespace klondike;
+
+namespace {
+
+struct SimulationTotals {
+    std::atomic<uint64_t> byStatus[4] = {};
+    std::atomic<uint64_t> moves{0};
+};
+
+// Plays the deals from `first` to the end of the batch out to the end
+// with `policy`.
+void Simulate(uint64_t first, int size, int maxMoves, BatchPolicy policy,
+              SimulationTotals& totals) {
+    Batch batch(size, maxMoves);
+    std::vector<uint64_t> seeds(static_cast<std::size_t>(size));
+    for (int i = 0; i < size; ++i) seeds[i] = first + uint64_t(i);
+    batch.reset(seeds.data());
+
+    std::vector<uint8_t> actions(static_cast<std::size_t>(size));
+    do {
+        batch.choose(policy, actions.data());
+    } while (batch.step(actions.data()) > 0);
+
+    uint64_t moves = 0;
+    for (int i = 0; i < size; ++i) {
+        ++totals.byStatus[batch.status()[i]];
+        moves += uint64_t(batch.moves(i));
+    }
+    totals.moves += moves;
+}
+
+}  // namespace
+
+int RunSimulate(int argc, char** argv) {
+    Args args(argc, argv);
+    const uint64_t from = args.number("from", 0);
+    const uint64_t count = args.number("count", 100'000);
+    const int batchSize = int(args.number("batch", 1024));
+    const int maxMoves = int(args.number("max-moves", 1000));
+    const std::string policyName = args.get("policy", "random");
+
+    BatchPolicy policy = RANDOM_POLICY;
+    if (policyName == "greedy") {
+        policy = GREEDY_POLICY;
+    } else if (policyName == "solver") {
+        policy = SOLVER_POLICY;
+    } else if (policyName != "random") {
+        std::fprintf(stderr, "unknown policy %s\n", policyName.c_str());
+        return 2;
+    }
+    if (batchSize <= 0 or maxMoves <= 0) {
+        std::fprintf(stderr, "--batch and --max-moves must be positive\n");
+        return 2;
+    }
+
+    ThreadPool pool(
+        unsigned(args.number("threads", std::thread::hardware_concurrency())));
+    SimulationTotals totals;
+    const auto begin = std::chrono::steady_clock::now();
+    for (uint64_t first = 0; first < count; first += uint64_t(batchSize)) {
+        const int size = int(std::min(uint64_t(batchSize), count - first));
+        pool.submit([&, first, size] {
+            Simulate(from + first, size, maxMoves, policy, totals);
+        });
+    }
+    pool.wait();
+
+    const double seconds = std::chrono::duration<double>(
+                               std::chrono::steady_clock::now() - begin)
+                               .count();
+    const auto share = [&](BatchStatus status) {
+        return count ? 100.0 * double(totals.byStatus[status]) / double(count)
+                     : 0.0;
+    };
+    std::printf("%llu games, %s policy, on %u threads in %.2fs: %.1f%% won, "
+                "%.1f%% stuck, %.1f%% out of moves; %.0f games/s, "
+                "%.2f Mmoves/s\n",
+                static_cast<unsigned long long>(count), policyName.c_str(),
+                pool.size(), seconds, share(BATCH_WON), share(BATCH_STUCK),
+                share(BATCH_OUT_OF_MOVES),
+                seconds > 0 ? double(count) / seconds : 0.0,
+                seconds > 0 ? double(totals.moves) / seconds / 1e6 : 0.0);
+    return 0;
+}
@@ -0,0 +1,57 @@
+#include <cstdio>
+#include <string_view>
+#include "Commands.hpp"
+
+namespace {
+
+struct Command {
+    const char* name;
+    int (*run)(int, char**);
+    const char* help;
+};
+
+const Command commands[] = {
+    {"analyze", RunAnalyze,
+     "--from SEED --count N [--threads N] [--nodes N] [--memory MB]\n"
+     "          [--format csv|binary] [--out FILE]\n"
+     "          solve a range of seeded deals on every core"},
+    {"check", RunCheck,
+     "\n          decode forged snapshots and fail if any gets through"},
+    {"deals", RunDeals,
+     "ANALYSIS... [--buckets N] [--out FILE]\n"
+     "          index binary analyze output into a deal database for\n"
+     "          the game's --difficulty"},
+    {"replay", RunReplay,
+     "FILE|DIR...\n"
+     "          play back recorded games headless and check every move"},
+    {"serve", RunServe,
+     "[--socket PATH] [--threads N]\n"
+     "          host game sessions for bots over a Unix socket"},
+    {"simulate", RunSimulate,
+     "--from SEED --count N [--policy random|greedy|solver] [--batch N]\n"
+     "          [--max-moves N] [--threads N]\n"
+     "          play many deals out in batches and report how they end"},
+};
+
+void PrintUsage() {
+    std::fprintf(stderr, "usage: klonkdike_cli <command> [options]\n\n");
+    for (const auto& command : commands) {
+        std::fprintf(stderr, "  %s %s\n", command.name, command.help);
+    }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        PrintUsage();
+        return 2;
+    }
+    for (const auto& command : commands) {
+        if (std::string_view(argv[1]) == command.name) {
+            return command.run(argc - 2, argv + 2);
+        }
+    }
+    PrintUsage();
+    return 2;
+}